@@ -0,0 +1,23 @@
+
+#include <thread>
+#include <benchmark/benchmark.hpp>
+#include <coroutine/call_with_stack.hpp>
+
+static int work(int v) { return v * 2; }
+
+BENCH(direct, 10000) {
+	BENCH_SWALLOW(work(BENCH_CNT));
+}
+
+BENCH(call_with_stack, 10000) {
+	BENCH_SWALLOW(coroutine::call_with_stack(64 << 20, work, BENCH_CNT));
+}
+
+BENCH(thread, 10000) {
+	int r;
+	std::thread t([&] { r = work(BENCH_CNT); });
+	t.join();
+	BENCH_SWALLOW(r);
+}
+
+BENCH_MAIN(call_with_stack)
@@ -0,0 +1,83 @@
+
+#include <vector>
+#include <benchmark/benchmark.hpp>
+#include <range.hpp>
+#include <coroutine/builder.hpp>
+#include <coroutine/generator.hpp>
+
+static const int N = 1000;
+
+// or the loop folds into n(n - 1) / 2.
+BENCH(loop, 10000) {
+	int s = 0;
+	for (int i = 0; i < N; ++i) {
+		s += i;
+		BENCH_OPAQUE(s);
+	}
+	BENCH_SWALLOW(s);
+}
+
+struct counter {
+	int i;
+
+	int operator()(coroutine::stackless_yielder<int ()> yield) {
+		CORO_REENTER(yield) {
+			for (i = 0; i < N - 1; ++i)
+				CORO_YIELD(yield, i);
+		}
+		return i;
+	}
+};
+
+BENCH(stackless, 10000) {
+	auto g = coroutine::coro<int (), coroutine::kind::stackless>(counter());
+	int s = 0;
+	for (auto x: coroutine::as_range(g))
+		s += x;
+	BENCH_SWALLOW(s);
+}
+
+BENCH(stackful, 10000) {
+	auto g = coroutine::coro<int (), coroutine::stack::size_in_kb<64> >(
+			[](coroutine::yielder<int ()> yield) {
+				int i = 0;
+				for (; i < N - 1; ++i)
+					yield(i);
+				return i;
+			});
+	int s = 0;
+	for (auto x: coroutine::as_range(g))
+		s += x;
+	BENCH_SWALLOW(s);
+}
+
+struct strided {
+	int i, start;
+
+	int operator()(coroutine::stackless_yielder<int ()> yield) {
+		CORO_REENTER(yield) {
+			for (i = 0; i < N - 1; ++i)
+				CORO_YIELD(yield, start + i * 64);
+		}
+		return start + i * 64;
+	}
+};
+
+BENCH(merge_64_stackless, 100) {
+	typedef decltype(coroutine::coro<int (), coroutine::kind::stackless>(
+				strided())) strided_t;
+	std::vector<strided_t> gens;
+	gens.reserve(64);
+	std::vector<coroutine::generator_range<strided_t> > heads;
+	for (int j = 0; j < 64; ++j) {
+		gens.push_back(coroutine::coro<int (), coroutine::kind::stackless>(
+					strided{0, j}));
+		heads.push_back(coroutine::as_range(gens.back()));
+	}
+	int s = 0;
+	for (auto x: merge(heads))
+		s += x;
+	BENCH_SWALLOW(s);
+}
+
+BENCH_MAIN(generator)
@@ -0,0 +1,57 @@
+
+#include <string>
+#include <benchmark/benchmark.hpp>
+#include <coroutine/parser.hpp>
+
+typedef coroutine::stack::size_in_kb<64> small_stack;
+
+static const size_t CHUNK = 4096;
+
+// about 1MB of length prefixed messages from 1 to 200 bytes.
+static std::string make_frames() {
+	std::string r;
+	for (size_t i = 0; r.size() < (1 << 20); ++i) {
+		const size_t n = 1 + i * 7 % 200;
+		r += char(n >> 24); r += char(n >> 16); r += char(n >> 8); r += char(n);
+		r.append(n, 'a' + i % 26);
+	}
+	return r;
+}
+
+// about 1MB of lines from 0 to 120 bytes.
+static std::string make_lines() {
+	std::string r;
+	for (size_t i = 0; r.size() < (1 << 20); ++i) {
+		r.append(i * 13 % 121, 'a' + i % 26);
+		r += '\n';
+	}
+	return r;
+}
+
+template <typename P>
+	void feed(P& p, const std::string& stream) {
+		for (size_t i = 0; i < stream.size(); i += CHUNK)
+			p(coroutine::slice(stream.data() + i,
+						std::min(CHUNK, stream.size() - i)));
+		p(coroutine::slice());
+	}
+
+BENCH_WF(length_prefixed_1MB, 100, make_frames()) {
+	size_t bytes = 0;
+	auto p = coroutine::make_parser<small_stack>(
+			coroutine::decoder::length_prefixed(
+				[&bytes](coroutine::slice m) { bytes += m.size; }));
+	feed(p, BENCH_FIXTURE);
+	BENCH_SWALLOW(bytes);
+}
+
+BENCH_WF(lines_1MB, 100, make_lines()) {
+	size_t bytes = 0;
+	auto p = coroutine::make_parser<small_stack>(
+			coroutine::decoder::lines(
+				[&bytes](coroutine::slice l) { bytes += l.size; }));
+	feed(p, BENCH_FIXTURE);
+	BENCH_SWALLOW(bytes);
+}
+
+BENCH_MAIN(parser)
@@ -0,0 +1,173 @@
+
+#include <unordered_map>
+#include <vector>
+#include <benchmark/benchmark.hpp>
+#include <algo.hpp>
+#include <lambdaexpr.hpp>
+
+static const long long N = 100000000;
+
+BENCH(loop_sum_100M, 10) {
+	long long s = 0;
+	for (long long i = 1; i < N; ++i)
+		s += i;
+	BENCH_SWALLOW(s);
+}
+
+// closed form.
+BENCH(sum_range_100M, 10) {
+	BENCH_SWALLOW(sum(range(1LL, N)));
+}
+
+// by index.
+BENCH(reduce_range_100M, 10) {
+	BENCH_SWALLOW(reduce([](long long a, long long b) { return a + b; },
+				range(1LL, N)));
+}
+
+BENCH_WF(loop_map_reduce_16M, 10, std::vector<int>(1 << 24, 3)) {
+	int s = 0;
+	for (int x: BENCH_FIXTURE)
+		s += x * 10;
+	BENCH_SWALLOW(s);
+}
+
+BENCH_WF(map_reduce_16M, 10, std::vector<int>(1 << 24, 3)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(reduce(_1 + _2, map(_1 * 10, a)));
+}
+
+// in cache. Element by element, trough operator[].
+BENCH_WF(reduce_16K, 10000, std::vector<int>(1 << 14, 3)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(reduce(_1 + _2, a));
+}
+
+// block by block.
+BENCH_WF(sum_16K, 10000, std::vector<int>(1 << 14, 3)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(sum(a));
+}
+
+BENCH_WF(sum_map_16K, 10000, std::vector<int>(1 << 14, 3)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(sum(map(_1 * 10, a)));
+}
+
+BENCH_WF(sum_filter_map_16K, 10000, std::vector<int>(1 << 14, 3)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(sum(filter(_1 > 10, map(_1 * 10, a))));
+}
+
+BENCH_WF(sum_float_16K, 10000, std::vector<float>(1 << 14, 0.5f)) {
+	ArrayRange<float> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(sum(a));
+}
+
+BENCH_WF(reduce_float_16K, 10000, std::vector<float>(1 << 14, 0.5f)) {
+	ArrayRange<float> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(reduce(_1 + _2, a));
+}
+
+// a batch transform: fused, then fused on every core. The range of a
+// for(:) loop outlives lambdaexpr constants, hence plain lambdas.
+static int times10(int v) { return v * 10; }
+static bool over10(int v) { return v > 10; }
+
+BENCH_WF(pipeline_4M, 10, std::vector<int>(1 << 22, 3)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	int s = 0;
+	for (int x: pipe(a).map(times10).filter(over10)) {
+		s += x;
+	}
+	BENCH_SWALLOW(s);
+}
+
+BENCH_WF(par_pipeline_4M, 10, std::vector<int>(1 << 22, 3)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	int s = 0;
+	for (int x: par(pipe(a).map(times10).filter(over10))) {
+		s += x;
+	}
+	BENCH_SWALLOW(s);
+}
+
+static std::vector<int> shuffled(size_t n) {
+	std::vector<int> v(n);
+	unsigned seed = 42;
+	for (int& x: v) {
+		seed = seed * 1103515245 + 12345;
+		x = seed >> 8;
+	}
+	return v;
+}
+
+BENCH_WF(partial_sort_100_4M, 10, shuffled(1 << 22)) {
+	std::vector<int> top(100);
+	std::partial_sort_copy(BENCH_FIXTURE.begin(), BENCH_FIXTURE.end(),
+			top.begin(), top.end(), [](int a, int b) { return a > b; });
+	BENCH_SWALLOW(top[99]);
+}
+
+BENCH_WF(top_100_4M, 10, shuffled(1 << 22)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(top_k(100, _1 * 10, a)[99]);
+}
+
+BENCH_WF(unordered_map_4K_groups_4M, 10, shuffled(1 << 22)) {
+	std::unordered_map<int, int> groups;
+	for (int x: BENCH_FIXTURE) {
+		groups[x & 4095] += x;
+	}
+	BENCH_SWALLOW(groups[7]);
+}
+
+BENCH_WF(group_by_4K_groups_4M, 10, shuffled(1 << 22)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(*group_by(_1 & 4095, _1 + _2, a).find(7));
+}
+
+// 1M build entries, 4M probes, one in four matching.
+BENCH_WF(unordered_multimap_join_1M_4M, 3, shuffled(1 << 22)) {
+	const std::vector<int>& v = BENCH_FIXTURE;
+	std::unordered_multimap<int, int> table;
+	for (size_t i = 0; i < v.size() / 4; ++i) {
+		table.emplace(v[i], v[i]);
+	}
+	long long s = 0;
+	for (int x: v) {
+		auto r = table.equal_range(x ^ 1);
+		for (auto it = r.first; it != r.second; ++it) {
+			s += it->second;
+		}
+	}
+	BENCH_SWALLOW(s);
+}
+
+BENCH_WF(hash_join_1M_4M, 3, shuffled(1 << 22)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	ArrayRange<int> b(BENCH_FIXTURE.data(), BENCH_FIXTURE.size() / 4);
+	long long s = 0;
+	for (auto e: hash_join(b, a, [](int x) { return x; },
+				[](int x) { return x ^ 1; })) {
+		s += get<0>(e);
+	}
+	BENCH_SWALLOW(s);
+}
+
+BENCH_WF(loop_scan_16M, 10, std::vector<int>(1 << 24, 3)) {
+	const std::vector<int>& v = BENCH_FIXTURE;
+	std::vector<int> out(v.size());
+	int acc = 0;
+	for (size_t i = 0; i < v.size(); ++i) {
+		out[i] = acc += v[i];
+	}
+	BENCH_SWALLOW(out.back());
+}
+
+BENCH_WF(par_inclusive_scan_16M, 10, std::vector<int>(1 << 24, 3)) {
+	ArrayRange<int> a(BENCH_FIXTURE.data(), BENCH_FIXTURE.size());
+	BENCH_SWALLOW(par_inclusive_scan(_1 + _2, a).back());
+}
+
+BENCH_MAIN(reduce)
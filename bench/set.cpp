@@ -0,0 +1,68 @@
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <benchmark/benchmark.hpp>
+#include <range.hpp>
+
+struct lists {
+	std::vector<int> a, b, few;
+	lists() {
+		for (int i = 0; i < 1 << 20; ++i) {
+			a.push_back(i * 3);
+			b.push_back(i * 5);
+		}
+		for (int i = 0; i < 1 << 10; ++i) {
+			few.push_back(i * 3001);
+		}
+	}
+};
+
+static ArrayRange<int> ar(std::vector<int>& v) {
+	return ArrayRange<int>(v.data(), v.size());
+}
+
+BENCH_WF(std_intersection_1M_1M, 100, lists()) {
+	lists& l = BENCH_FIXTURE;
+	std::vector<int> out;
+	std::set_intersection(l.a.begin(), l.a.end(), l.b.begin(), l.b.end(),
+			std::back_inserter(out));
+	BENCH_SWALLOW(out.size());
+}
+
+BENCH_WF(intersection_1M_1M, 100, lists()) {
+	lists& l = BENCH_FIXTURE;
+	int n = 0;
+	for (int x: set_intersection(ar(l.a), ar(l.b))) {
+		n += x & 1;
+	}
+	BENCH_SWALLOW(n);
+}
+
+BENCH_WF(std_intersection_1K_1M, 100, lists()) {
+	lists& l = BENCH_FIXTURE;
+	std::vector<int> out;
+	std::set_intersection(l.few.begin(), l.few.end(), l.a.begin(), l.a.end(),
+			std::back_inserter(out));
+	BENCH_SWALLOW(out.size());
+}
+
+BENCH_WF(intersection_1K_1M, 100, lists()) {
+	lists& l = BENCH_FIXTURE;
+	int n = 0;
+	for (int x: set_intersection(ar(l.few), ar(l.a))) {
+		n += x & 1;
+	}
+	BENCH_SWALLOW(n);
+}
+
+BENCH_WF(difference_1M_1M, 100, lists()) {
+	lists& l = BENCH_FIXTURE;
+	int n = 0;
+	for (int x: set_difference(ar(l.a), ar(l.b))) {
+		n += x & 1;
+	}
+	BENCH_SWALLOW(n);
+}
+
+BENCH_MAIN(set)
@@ -0,0 +1,90 @@
+
+#include <vector>
+#include <benchmark/benchmark.hpp>
+#include <range.hpp>
+#include <soa_vector.hpp>
+
+static const size_t N = 1 << 16;
+
+struct arrays {
+	std::vector<int> a, b, c, d;
+	arrays(): a(N, 1), b(N, 2), c(N, 3), d(N - N / 4, 4) {}
+};
+
+BENCH_WF(loop_4, 1000, arrays()) {
+	const arrays& x = BENCH_FIXTURE;
+	int s = 0;
+	for (size_t i = 0; i < N; ++i)
+		s += x.a[i] + x.b[i] + x.c[i] + (i < x.d.size() ? x.d[i] : -1);
+	BENCH_SWALLOW(s);
+}
+
+BENCH_WF(zip_4, 1000, arrays()) {
+	arrays& x = BENCH_FIXTURE;
+	int s = 0;
+	for (auto e: zip(ArrayRange<int>(x.a.data(), N),
+				ArrayRange<int>(x.b.data(), N),
+				ArrayRange<int>(x.c.data(), N),
+				ArrayRange<int>(x.d.data(), x.d.size())))
+		s += get<0>(e) + get<1>(e) + get<2>(e) + get<3>(e);
+	BENCH_SWALLOW(s);
+}
+
+BENCH_WF(longzip_4, 1000, arrays()) {
+	arrays& x = BENCH_FIXTURE;
+	int s = 0;
+	for (auto e: longzip(-1, ArrayRange<int>(x.a.data(), N),
+				ArrayRange<int>(x.b.data(), N),
+				ArrayRange<int>(x.c.data(), N),
+				ArrayRange<int>(x.d.data(), x.d.size())))
+		s += get<0>(e) + get<1>(e) + get<2>(e) + get<3>(e);
+	BENCH_SWALLOW(s);
+}
+
+BENCH_WF(zip_4_mapped, 1000, arrays()) {
+	arrays& x = BENCH_FIXTURE;
+	int s = 0;
+	auto twice = [](int v) { return v * 2; };
+	for (auto e: zip(map(twice, ArrayRange<int>(x.a.data(), N)),
+				map(twice, ArrayRange<int>(x.b.data(), N)),
+				map(twice, ArrayRange<int>(x.c.data(), N)),
+				map(twice, ArrayRange<int>(x.d.data(), x.d.size()))))
+		s += get<0>(e) + get<1>(e) + get<2>(e) + get<3>(e);
+	BENCH_SWALLOW(s);
+}
+
+// one field out of rows of 32 bytes: every row goes trough the cache, or
+// only the column.
+typedef tuple<int, double, long long, long long> row_t;
+
+static std::vector<row_t> aos_rows() {
+	std::vector<row_t> v;
+	for (size_t i = 0; i < N * 16; ++i) {
+		v.push_back(row_t(int(i), 0.5, 1LL, 2LL));
+	}
+	return v;
+}
+
+static soa_vector<int, double, long long, long long> soa_rows() {
+	soa_vector<int, double, long long, long long> v;
+	for (size_t i = 0; i < N * 16; ++i) {
+		v.push_back(int(i), 0.5, 1LL, 2LL);
+	}
+	return v;
+}
+
+BENCH_WF(aos_column_scan, 100, aos_rows()) {
+	int s = 0;
+	for (const row_t& r: BENCH_FIXTURE)
+		s += get_ref<0>(r);
+	BENCH_SWALLOW(s);
+}
+
+BENCH_WF(soa_column_scan, 100, soa_rows()) {
+	int s = 0;
+	for (int x: BENCH_FIXTURE.column<0>())
+		s += x;
+	BENCH_SWALLOW(s);
+}
+
+BENCH_MAIN(zip)
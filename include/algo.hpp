@@ -0,0 +1,1394 @@
+/*
+ * algo.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef ALGO_H
+#define ALGO_H
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "tools.hpp"
+#include "range.hpp"
+#include "thread_pool.hpp"
+
+// below this many elements per chunk, reduce() stays on the calling thread.
+#ifndef REDUCE_PAR_GRAIN
+#	define REDUCE_PAR_GRAIN 16384
+#endif
+
+// independent accumulators of fold_blocks(), so the inner loop vectorizes.
+#ifndef RANGE_BLOCK_LANES
+#	define RANGE_BLOCK_LANES 8
+#endif
+
+// group_by() pre-sizes its table from size(), up to this many groups. Past
+// that it grows as needed: sized for every element, a table with few
+// groups would spread them over many more cache lines.
+#ifndef GROUP_BY_RESERVE
+#	define GROUP_BY_RESERVE 4096
+#endif
+
+// hash_join() partitions its build side first when the table would not fit
+// in this many bytes (about a L2 cache).
+#ifndef HASH_JOIN_PARTITION_BYTES
+#	define HASH_JOIN_PARTITION_BYTES (256 * 1024)
+#endif
+
+// probe elements hashed and prefetched together by hash_join().
+#ifndef HASH_JOIN_BATCH
+#	define HASH_JOIN_BATCH 16
+#endif
+
+// source elements per morsel of par().
+#ifndef PAR_MORSEL
+#	define PAR_MORSEL 4096
+#endif
+
+template <typename R>
+bool any(R r) {
+	for (auto x: r) {
+		if (bool(x)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename R>
+bool all(R r) {
+	for (auto x: r) {
+		if (not bool(x)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// reduce a range though a function
+template <typename F, typename R>
+struct Reducer {
+	typedef decltype( (*(F*)0)( (*(R*)0).front(), (*(R*)0).front()) ) return_t;
+
+	Reducer(F f, R r): _f(f), _r(r) {}
+
+	bool empty() const { return _r.empty(); }
+	void pop_front() { _r.pop_front(); }
+	return_t front() {
+		return _f(_r.front());
+	}
+
+	F _f;
+	R _r;
+};
+
+namespace details {
+
+	template <typename R>
+	struct is_random_finite_range {
+		static const bool value = is_random_range<R>::value
+			and is_finite_range<R>::value;
+	};
+
+	// f(...f(f(r[b], r[b+1]), r[b+2])..., r[e-1])
+	template <typename F, typename R>
+	auto reduce_index(F& f, R& r, size_t b, size_t e)
+		-> decltype(f(r.front(), r.front())) {
+		decltype(f(r.front(), r.front())) sum = r[b];
+		for (size_t i = b + 1; i < e; ++i) {
+			sum = f(sum, r[i]);
+		}
+		return sum;
+	}
+
+} // namespace details
+
+template <typename F, typename R>
+auto reduce(F f, R r) -> typename std::enable_if<
+	not details::is_random_finite_range<R>::value,
+	decltype(f(r.front(), r.front()))>::type {
+	if (r.empty()) {
+		throw std::range_error("cannot reduce an empty range!");
+	}
+
+	decltype(f(r.front(), r.front())) sum = r.front();
+	r.pop_front();
+
+	for (auto x: r) {
+		sum = f(sum, x);
+	}
+	return sum;
+}
+
+// random and finite: split by index over the thread pool, every chunk is
+// reduced by its own copy of f and r, and the partial results are combined
+// in order. So f has to be associative, not commutative. Floating point
+// addition is only nearly so: the result then depends on how the pool
+// splits the range (its workers, REDUCE_PAR_GRAIN), not only on r.
+template <typename F, typename R>
+auto reduce(F f, R r) -> typename std::enable_if<
+	details::is_random_finite_range<R>::value,
+	decltype(f(r.front(), r.front()))>::type {
+	typedef decltype(f(r.front(), r.front())) return_t;
+	typedef typename std::decay<return_t>::type value_t;
+
+	const size_t n = r.size();
+	if (not n) {
+		throw std::range_error("cannot reduce an empty range!");
+	}
+
+	thread_pool& pool = thread_pool::instance();
+	const size_t chunks = std::min(pool.size() * 4, n / REDUCE_PAR_GRAIN);
+	if (chunks < 2) {
+		return details::reduce_index(f, r, 0, n);
+	}
+
+	std::vector<std::unique_ptr<value_t>> partials(chunks);
+	pool.parallel_for(chunks, [&](size_t c) {
+			F lf(f);
+			R lr(r);
+			partials[c].reset(new value_t(details::reduce_index(lf, lr,
+							n * c / chunks, n * (c + 1) / chunks)));
+		});
+
+	value_t sum = *partials[0];
+	for (size_t c = 1; c < chunks; ++c) {
+		sum = f(sum, *partials[c]);
+	}
+	return sum;
+}
+
+namespace details {
+
+	struct adder {
+		template <typename A, typename B>
+			auto operator()(const A& a, const B& b) -> decltype(a + b) {
+				return a + b;
+			}
+	};
+
+	struct multiplier {
+		template <typename A, typename B>
+			auto operator()(const A& a, const B& b) -> decltype(a * b) {
+				return a * b;
+			}
+	};
+}
+
+namespace details {
+
+	// what visit() hands over, identity when the element is filtered out:
+	// the fold itself stays branch free.
+	template <typename T>
+	struct fold_value {
+		T& v;
+		template <typename E>
+		void operator()(E&& e) { v = T(std::forward<E>(e)); }
+	};
+
+	template <typename T, typename R, typename X>
+	T fold_elem(const T& identity, R& r, X& x) {
+		T v = identity;
+		fold_value<T> k{v};
+		r.visit(x, k);
+		return v;
+	}
+
+	template <typename OP, typename T, typename R>
+	T fold_blocks_seq(OP& op, const T& identity, R& r) {
+		const size_t W = RANGE_BLOCK_LANES;
+		T lanes[W];
+		for (size_t j = 0; j < W; ++j) {
+			lanes[j] = identity;
+		}
+		auto& src = r.block_source();
+		for (;;) {
+			auto b = src.next_block();
+			if (b.empty()) {
+				break;
+			}
+			size_t i = 0;
+			for (; i + W <= b.size; i += W) {
+				for (size_t j = 0; j < W; ++j) {
+					lanes[j] = op(lanes[j], fold_elem(identity, r, b[i + j]));
+				}
+			}
+			for (; i < b.size; ++i) {
+				lanes[0] = op(lanes[0], fold_elem(identity, r, b[i]));
+			}
+		}
+		T acc = lanes[0];
+		for (size_t j = 1; j < W; ++j) {
+			acc = op(acc, lanes[j]);
+		}
+		return acc;
+	}
+
+} // namespace details
+
+// fold a block range (see is_block_range) a whole block at a time, in tight
+// loops of RANGE_BLOCK_LANES accumulators, instead of one front() and
+// pop_front() per element. Big sources are split over the thread pool.
+// op has to be associative and commutative, identity its neutral element.
+template <typename OP, typename T, typename R>
+T fold_blocks(OP op, T identity, R r) {
+	auto& src = r.block_source();
+	typedef typename std::decay<decltype(src)>::type source_t;
+	const size_t n = src.empty() ? 0 : src.size();
+
+	thread_pool& pool = thread_pool::instance();
+	const size_t chunks = std::min(pool.size() * 4, n / REDUCE_PAR_GRAIN);
+	if (chunks < 2) {
+		return details::fold_blocks_seq(op, identity, r);
+	}
+
+	auto base = &src.front();
+	std::vector<std::unique_ptr<T>> partials(chunks);
+	pool.parallel_for(chunks, [&](size_t c) {
+			OP lop(op);
+			R lr(r);
+			const size_t b = n * c / chunks;
+			const size_t e = n * (c + 1) / chunks;
+			lr.block_source() = source_t(base + b, e - b);
+			partials[c].reset(new T(details::fold_blocks_seq(lop, identity, lr)));
+		});
+
+	T acc = *partials[0];
+	for (size_t c = 1; c < chunks; ++c) {
+		acc = op(acc, *partials[c]);
+	}
+	return acc;
+}
+
+template <typename R>
+auto sum(R r) -> typename std::enable_if<not is_block_range<R>::value,
+	decltype(reduce(details::adder(), r))>::type {
+	return reduce(details::adder(), r);
+}
+
+template <typename R>
+auto sum(R r) -> typename std::enable_if<is_block_range<R>::value,
+	decltype(reduce(details::adder(), r))>::type {
+	typedef typename std::decay<
+		decltype(reduce(details::adder(), r))>::type value_t;
+	if (r.empty()) {
+		throw std::range_error("cannot reduce an empty range!");
+	}
+	return fold_blocks(details::adder(), value_t(0), r);
+}
+
+// O(1), see NumberRange::sum().
+template <typename T>
+T sum(NumberRange<T> r) {
+	if (r.empty()) {
+		throw std::range_error("cannot reduce an empty range!");
+	}
+	return r.sum();
+}
+
+template <typename R>
+auto product(R r) -> typename std::enable_if<not is_block_range<R>::value,
+	decltype(reduce(details::multiplier(), r))>::type {
+	return reduce(details::multiplier(), r);
+}
+
+template <typename R>
+auto product(R r) -> typename std::enable_if<is_block_range<R>::value,
+	decltype(reduce(details::multiplier(), r))>::type {
+	typedef typename std::decay<
+		decltype(reduce(details::multiplier(), r))>::type value_t;
+	if (r.empty()) {
+		throw std::range_error("cannot reduce an empty range!");
+	}
+	return fold_blocks(details::multiplier(), value_t(1), r);
+}
+
+// the running fold of a range: r[0], f(r[0], r[1]), f(f(r[0], r[1]), r[2])...
+template <typename F, typename R>
+struct InclusiveScanner {
+	typedef typename std::decay<decltype(std::declval<F&>()(
+				std::declval<R&>().front(), std::declval<R&>().front()))>::type
+		value_t;
+
+	InclusiveScanner(F f, R r): _f(f), _r(r), _acc() {
+		if (not _r.empty()) {
+			_acc = _r.front();
+		}
+	}
+
+	bool empty() const { return _r.empty(); }
+	const value_t& front() const { return _acc; }
+
+	void pop_front() {
+		_r.pop_front();
+		if (not _r.empty()) {
+			_acc = _f(_acc, _r.front());
+		}
+	}
+
+	// finite when R is.
+	template <typename U = R>
+	auto size() const -> decltype(std::declval<const U&>().size()) {
+		return _r.size();
+	}
+
+	F       _f;
+	R       _r;
+	value_t _acc;
+};
+
+// the same, shifted by one and starting from init: the last fold is left
+// out, so there are as many elements as in r.
+template <typename F, typename T, typename R>
+struct ExclusiveScanner {
+	typedef typename std::decay<decltype(std::declval<F&>()(
+				std::declval<T&>(), std::declval<R&>().front()))>::type value_t;
+
+	ExclusiveScanner(F f, T init, R r): _f(f), _r(r), _acc(init) {}
+
+	bool empty() const { return _r.empty(); }
+	const value_t& front() const { return _acc; }
+
+	void pop_front() {
+		_acc = _f(_acc, _r.front());
+		_r.pop_front();
+	}
+
+	template <typename U = R>
+	auto size() const -> decltype(std::declval<const U&>().size()) {
+		return _r.size();
+	}
+
+	F       _f;
+	R       _r;
+	value_t _acc;
+};
+
+template <typename F, typename R>
+InclusiveScanner<F, R> inclusive_scan(F f, R r) { return {f, r}; }
+
+template <typename F, typename T, typename R>
+ExclusiveScanner<F, T, R> exclusive_scan(F f, T init, R r) {
+	return {f, init, r};
+}
+
+namespace details {
+
+	// the fold of every chunk of r, on the thread pool.
+	template <typename V, typename F, typename R>
+	std::vector<V> scan_partials(thread_pool& pool, F& f, R& r,
+			size_t n, size_t chunks) {
+		std::vector<V> partials(chunks);
+		pool.parallel_for(chunks, [&](size_t c) {
+				F lf(f);
+				R lr(r);
+				partials[c] = reduce_index(lf, lr, n * c / chunks,
+						n * (c + 1) / chunks);
+			});
+		return partials;
+	}
+
+	template <typename R>
+	size_t scan_chunks(thread_pool& pool, R& r) {
+		return std::min(pool.size() * 4, r.size() / REDUCE_PAR_GRAIN);
+	}
+
+} // namespace details
+
+// inclusive_scan() of a random and finite range, in two passes over the
+// thread pool: every chunk is folded, the folds are scanned, then every
+// chunk is scanned again from the fold of the chunks before it. So f has
+// to be associative, and the result is stored.
+template <typename F, typename R>
+std::vector<typename InclusiveScanner<F, R>::value_t> par_inclusive_scan(
+		F f, R r) {
+	typedef typename InclusiveScanner<F, R>::value_t value_t;
+	static_assert(details::is_random_finite_range<R>::value,
+			"par_inclusive_scan() needs a random and finite range");
+
+	const size_t n = r.size();
+	std::vector<value_t> out(n);
+	thread_pool& pool = thread_pool::instance();
+	const size_t chunks = std::max(size_t(1), details::scan_chunks(pool, r));
+	std::vector<value_t> carry;
+	if (chunks > 1) {
+		carry = details::scan_partials<value_t>(pool, f, r, n, chunks);
+		for (size_t c = 1; c < chunks; ++c) {
+			carry[c] = f(carry[c - 1], carry[c]);
+		}
+	}
+
+	pool.parallel_for(chunks, [&](size_t c) {
+			F lf(f);
+			R lr(r);
+			const size_t b = n * c / chunks;
+			const size_t e = n * (c + 1) / chunks;
+			if (b == e) {
+				return;
+			}
+			value_t acc = c ? lf(carry[c - 1], lr[b]) : value_t(lr[b]);
+			out[b] = acc;
+			for (size_t i = b + 1; i < e; ++i) {
+				acc = lf(acc, lr[i]);
+				out[i] = acc;
+			}
+		});
+	return out;
+}
+
+template <typename F, typename T, typename R>
+std::vector<typename ExclusiveScanner<F, T, R>::value_t> par_exclusive_scan(
+		F f, T init, R r) {
+	typedef typename ExclusiveScanner<F, T, R>::value_t value_t;
+	static_assert(details::is_random_finite_range<R>::value,
+			"par_exclusive_scan() needs a random and finite range");
+
+	const size_t n = r.size();
+	std::vector<value_t> out(n);
+	thread_pool& pool = thread_pool::instance();
+	const size_t chunks = std::max(size_t(1), details::scan_chunks(pool, r));
+	std::vector<value_t> carry(1, init);
+	if (chunks > 1) {
+		carry = details::scan_partials<value_t>(pool, f, r, n, chunks);
+		// shifted: the carry into chunk c.
+		carry.insert(carry.begin(), init);
+		for (size_t c = 1; c < chunks; ++c) {
+			carry[c] = f(carry[c - 1], carry[c]);
+		}
+	}
+
+	pool.parallel_for(chunks, [&](size_t c) {
+			F lf(f);
+			R lr(r);
+			value_t acc = carry[c];
+			const size_t e = n * (c + 1) / chunks;
+			for (size_t i = n * c / chunks; i < e; ++i) {
+				out[i] = acc;
+				acc = lf(acc, lr[i]);
+			}
+		});
+	return out;
+}
+
+// filter a range through a function
+template <typename F, typename R>
+struct Filterer {
+	typedef decltype( (*(R*)0).front() ) return_t;
+
+	Filterer(F f, R r): _f(f), _r(r) {
+		_discard();
+	}
+
+	bool empty() const { return _r.empty(); }
+	void pop_front() {
+		_r.pop_front();
+		_discard();
+	}
+	return_t front() {
+		return _r.front();
+	}
+
+	// a block range when R is.
+	template <typename U = R>
+	auto block_source() -> decltype(std::declval<U&>().block_source()) {
+		return _r.block_source();
+	}
+	// the element is evaluated once, tested, and handed over as is.
+	template <typename K>
+	struct visitor {
+		F& f;
+		K& k;
+		template <typename E>
+		void operator()(E&& e) {
+			if (f(e)) {
+				k(std::forward<E>(e));
+			}
+		}
+	};
+	template <typename X, typename K>
+	void visit(X& x, K& k) {
+		visitor<K> v{_f, k};
+		_r.visit(x, v);
+	}
+
+	void _discard() {
+		for (auto x: _r) {
+			if (_f(x)) {
+				break;
+			}
+		}
+	}
+
+	F _f;
+	R _r;
+};
+
+template <typename F, typename R>
+Filterer<F, R> filter(F f, R r) { return {f, r}; }
+
+// fused pipelines: pipe(r).map(f).filter(p)... or fuse(map(f, filter(p, r))).
+// The whole chain of stages runs as a single loop body per source element,
+// every stage hands its result straight to the next one, and the final
+// value is cached. So f and p run exactly once per element, however many
+// times front() is called.
+namespace details {
+
+	struct identity_kernel {
+		template <typename X>
+		struct result { typedef X type; };
+
+		template <typename X, typename Sink>
+		bool run(X&& x, Sink& sink) { return sink(std::forward<X>(x)); }
+	};
+
+	template <typename F>
+	struct map_stage {
+		F f;
+
+		template <typename X>
+		struct result {
+			typedef decltype(std::declval<F&>()(std::declval<X>())) type;
+		};
+
+		template <typename X, typename Sink>
+		bool run(X&& x, Sink& sink) { return sink(f(std::forward<X>(x))); }
+	};
+
+	template <typename F>
+	struct filter_stage {
+		F f;
+
+		template <typename X>
+		struct result { typedef X type; };
+
+		template <typename X, typename Sink>
+		bool run(X&& x, Sink& sink) {
+			return f(x) ? sink(std::forward<X>(x)) : false;
+		}
+	};
+
+	// S, fed with the output of K.
+	template <typename K, typename S>
+	struct then {
+		K k;
+		S s;
+
+		template <typename X>
+		struct result {
+			typedef typename S::template result<
+				typename K::template result<X>::type>::type type;
+		};
+
+		template <typename Sink>
+		struct bound {
+			S&    s;
+			Sink& sink;
+
+			template <typename X>
+			bool operator()(X&& x) { return s.run(std::forward<X>(x), sink); }
+		};
+
+		template <typename X, typename Sink>
+		bool run(X&& x, Sink& sink) {
+			bound<Sink> b = {s, sink};
+			return k.run(std::forward<X>(x), b);
+		}
+	};
+
+} // namespace details
+
+template <typename R, typename K = details::identity_kernel>
+struct Pipeline {
+	typedef typename std::decay<typename K::template result<
+		typename range_info<R>::type>::type>::type value_t;
+
+	Pipeline(R r, K k = K()): _r(r), _k(k), _primed(false), _has(false) {}
+
+	Pipeline(const Pipeline& from):
+		_r(from._r), _k(from._k), _primed(from._primed), _has(false) {
+		if (from._has) {
+			set(from.cur());
+		}
+	}
+
+	Pipeline& operator=(const Pipeline&) = delete;
+
+	~Pipeline() { reset(); }
+
+	bool empty() const {
+		prime();
+		return not _has;
+	}
+
+	const value_t& front() const {
+		prime();
+		return cur();
+	}
+
+	void pop_front() {
+		prime();
+		reset();
+		_r.pop_front();
+		advance();
+	}
+
+	// nothing runs until the first access, stages can be appended freely.
+	template <typename F>
+	Pipeline<R, details::then<K, details::map_stage<F>>> map(F f) const {
+		return {_r, {_k, {f}}};
+	}
+
+	template <typename F>
+	Pipeline<R, details::then<K, details::filter_stage<F>>> filter(F f) const {
+		return {_r, {_k, {f}}};
+	}
+
+	struct store {
+		const Pipeline* p;
+
+		template <typename X>
+		bool operator()(X&& x) {
+			p->set(std::forward<X>(x));
+			return true;
+		}
+	};
+
+	mutable R    _r;
+	mutable K    _k;
+	mutable bool _primed;
+	mutable bool _has;
+	mutable typename std::aligned_storage<sizeof (value_t),
+		std::alignment_of<value_t>::value>::type _cur;
+
+	const value_t& cur() const {
+		return *reinterpret_cast<const value_t*>(&_cur);
+	}
+
+	template <typename X>
+	void set(X&& x) const {
+		new (&_cur) value_t(std::forward<X>(x));
+		_has = true;
+	}
+
+	void reset() const {
+		if (_has) {
+			reinterpret_cast<value_t*>(&_cur)->~value_t();
+			_has = false;
+		}
+	}
+
+	void prime() const {
+		if (not _primed) {
+			_primed = true;
+			advance();
+		}
+	}
+
+	// run the stages on source elements, until one goes trough all of them.
+	void advance() const {
+		store sink = {this};
+		for (; not _r.empty(); _r.pop_front()) {
+			if (_k.run(_r.front(), sink)) {
+				return;
+			}
+		}
+	}
+};
+
+template <typename R>
+Pipeline<R> pipe(R r) { return Pipeline<R>(r); }
+
+// turn nested Mappers and Filterers into one Pipeline. The elements a
+// Filterer already skipped when built are not looked at again, but the one
+// it stopped on is.
+template <typename R>
+Pipeline<R> fuse(R r) { return Pipeline<R>(r); }
+
+template <typename R, typename K>
+Pipeline<R, K> fuse(Pipeline<R, K> p) { return p; }
+
+template <typename F, typename R>
+auto fuse(Mapper<F, R> m) -> decltype(fuse(m._r).map(m._f)) {
+	return fuse(m._r).map(m._f);
+}
+
+template <typename F, typename R>
+auto fuse(Filterer<F, R> f) -> decltype(fuse(f._r).filter(f._f)) {
+	return fuse(f._r).filter(f._f);
+}
+
+namespace details {
+
+	template <typename T>
+	struct append_sink {
+		std::vector<T>& out;
+
+		template <typename X>
+		bool operator()(X&& x) {
+			out.emplace_back(std::forward<X>(x));
+			return true;
+		}
+	};
+
+} // namespace details
+
+// a Pipeline over a random and finite source, run on a thread pool. The
+// source is cut in morsels of consecutive elements, every morsel goes
+// trough its own copy of the stages into its own buffer, and the buffers
+// are then read one after the other, in source order. Everything runs at
+// the first access, the buffers are shared by the copies.
+template <typename R, typename K>
+struct ParPipeline {
+	static_assert(details::is_random_finite_range<R>::value,
+			"par() needs a random and finite source");
+
+	typedef typename Pipeline<R, K>::value_t value_t;
+	typedef std::vector<std::vector<value_t>> buffers_t;
+
+	ParPipeline(R r, K k, thread_pool* pool = &thread_pool::instance(),
+			size_t morsel = PAR_MORSEL):
+		_r(r), _k(k), _pool(pool), _morsel(std::max(size_t(1), morsel)),
+		_m(0), _i(0) {}
+
+	ParPipeline morsel(size_t n) const {
+		return {_r, _k, _pool, n};
+	}
+
+	ParPipeline on(thread_pool& pool) const {
+		return {_r, _k, &pool, _morsel};
+	}
+
+	bool empty() const {
+		run();
+		return _m == _bufs->size();
+	}
+
+	const value_t& front() const {
+		run();
+		return (*_bufs)[_m][_i];
+	}
+
+	void pop_front() {
+		run();
+		if (++_i == (*_bufs)[_m].size()) {
+			_i = 0;
+			++_m;
+			skip();
+		}
+	}
+
+	R                                        _r;
+	K                                        _k;
+	thread_pool*                             _pool;
+	size_t                                   _morsel;
+	mutable std::shared_ptr<const buffers_t> _bufs;
+	mutable size_t                           _m;
+	mutable size_t                           _i;
+
+	void run() const {
+		if (_bufs) {
+			return;
+		}
+		const size_t n = _r.size();
+		const size_t count = (n + _morsel - 1) / _morsel;
+		std::shared_ptr<buffers_t> bufs(new buffers_t(count));
+		_pool->parallel_for(count, [&](size_t c) {
+				R lr(_r);
+				K lk(_k);
+				const size_t b = c * _morsel;
+				const size_t e = std::min(n, b + _morsel);
+				std::vector<value_t> out;
+				out.reserve(e - b);
+				details::append_sink<value_t> sink = {out};
+				for (size_t i = b; i < e; ++i) {
+					lk.run(lr[i], sink);
+				}
+				(*bufs)[c].swap(out);
+			});
+		_bufs = bufs;
+		skip();
+	}
+
+	void skip() const {
+		while (_m < _bufs->size() and (*_bufs)[_m].empty()) {
+			++_m;
+		}
+	}
+};
+
+namespace details {
+
+	template <typename P>
+	struct par_of;
+
+	template <typename R, typename K>
+	struct par_of<Pipeline<R, K>> { typedef ParPipeline<R, K> type; };
+
+} // namespace details
+
+// a Pipeline, or whatever fuse() turns into one.
+template <typename R>
+typename details::par_of<decltype(fuse(std::declval<R>()))>::type par(R r) {
+	auto p = fuse(r);
+	return {p._r, p._k};
+}
+
+namespace details {
+
+	// the k elements with the greatest keys seen so far, in a heap with the
+	// smallest of them on top: most elements are turned down by a single
+	// comparison with it.
+	template <typename K, typename V>
+	struct top_heap {
+		typedef std::pair<K, V> entry_t;
+
+		struct later {
+			bool operator()(const entry_t& a, const entry_t& b) const {
+				return b.first < a.first;
+			}
+		};
+
+		size_t               k;
+		std::vector<entry_t> heap;
+
+		explicit top_heap(size_t k): k(k) { heap.reserve(k); }
+
+		template <typename X>
+		void push(K key, X&& x) {
+			if (heap.size() < k) {
+				heap.emplace_back(std::move(key), std::forward<X>(x));
+				std::push_heap(heap.begin(), heap.end(), later());
+			} else if (heap.front().first < key) {
+				std::pop_heap(heap.begin(), heap.end(), later());
+				heap.back() = entry_t(std::move(key), std::forward<X>(x));
+				std::push_heap(heap.begin(), heap.end(), later());
+			}
+		}
+
+		// the greatest key first.
+		std::vector<V> sorted() {
+			std::sort_heap(heap.begin(), heap.end(), later());
+			std::vector<V> r;
+			r.reserve(heap.size());
+			for (entry_t& e: heap) {
+				r.push_back(std::move(e.second));
+			}
+			return r;
+		}
+	};
+
+	template <typename F, typename R>
+	struct top_types {
+		typedef typename std::decay<
+			typename range_info<R>::type>::type value_t;
+		typedef typename std::decay<decltype(std::declval<F&>()(
+					std::declval<R&>().front()))>::type key_t;
+		typedef top_heap<key_t, value_t> heap_t;
+	};
+
+} // namespace details
+
+// the k elements of r with the greatest key(x), the greatest first. In
+// O(n log k) time and O(k) space, elements with equal keys come in no
+// particular order.
+template <typename F, typename R>
+auto top_k(size_t k, F key, R r) -> typename std::enable_if<
+	not details::is_random_finite_range<R>::value,
+	std::vector<typename details::top_types<F, R>::value_t>>::type {
+	typename details::top_types<F, R>::heap_t heap(k);
+	if (k) {
+		for (auto&& x: r) {
+			heap.push(key(x), x);
+		}
+	}
+	return heap.sorted();
+}
+
+// random and finite: one heap per chunk on the thread pool, then merged.
+template <typename F, typename R>
+auto top_k(size_t k, F key, R r) -> typename std::enable_if<
+	details::is_random_finite_range<R>::value,
+	std::vector<typename details::top_types<F, R>::value_t>>::type {
+	typedef typename details::top_types<F, R>::heap_t heap_t;
+
+	const size_t n = r.size();
+	thread_pool& pool = thread_pool::instance();
+	const size_t chunks = std::max(size_t(1),
+			std::min(pool.size() * 4, n / REDUCE_PAR_GRAIN));
+
+	// built by the jobs, each in a local for its inner loop.
+	std::vector<heap_t> heaps(chunks, heap_t(0));
+	if (k) {
+		pool.parallel_for(chunks, [&](size_t c) {
+				F lf(key);
+				R lr(r);
+				heap_t local(k);
+				const size_t e = n * (c + 1) / chunks;
+				for (size_t i = n * c / chunks; i < e; ++i) {
+					auto&& x = lr[i];
+					local.push(lf(x), x);
+				}
+				heaps[c] = std::move(local);
+			});
+	}
+
+	heap_t& top = heaps[0];
+	for (size_t c = 1; c < chunks; ++c) {
+		for (auto& e: heaps[c].heap) {
+			top.push(std::move(e.first), std::move(e.second));
+		}
+	}
+	return top.sorted();
+}
+
+namespace details {
+
+	// Fibonacci hashing: the high bits of the product are well mixed, even
+	// from a weak std::hash (the identity, for integers).
+	inline uint64_t fibonacci(size_t h) {
+		return uint64_t(h) * 0x9E3779B97F4A7C15ull;
+	}
+
+	// log2 of the smallest power of two >= n, at least 1.
+	inline unsigned log2_ceil(size_t n) {
+		unsigned b = 1;
+		while ((size_t(1) << b) < n) {
+			++b;
+		}
+		return b;
+	}
+
+	inline void prefetch(const void* p) {
+#ifdef __GNUC__
+		__builtin_prefetch(p);
+#else
+		(void)p;
+#endif
+	}
+
+} // namespace details
+
+// an open addressing hash table, as built by group_by(). Linear probing
+// over three arrays: the occupancy, the keys and the values. A probe walks
+// consecutive bytes and keys, a value is only touched once its key
+// matched. The load stays under 1/2. K and V must be default
+// constructible.
+template <typename K, typename V, typename H = std::hash<K>>
+class GroupTable {
+	public:
+		explicit GroupTable(size_t expected = 0, H hash = H()):
+			_hash(hash), _size(0) {
+			size_t cap = 8;
+			while (cap < expected * 2) {
+				cap *= 2;
+			}
+			rehash(cap);
+		}
+
+		size_t size() const { return _size; }
+		bool empty() const { return not _size; }
+
+		// nullptr when there is no such group.
+		const V* find(const K& k) const {
+			const size_t i = probe(k);
+			return _used[i] ? &_values[i] : nullptr;
+		}
+
+		// x is the first element of its group, or aggregated into it.
+		template <typename X, typename A>
+		void add(K k, X&& x, A& agg) {
+			size_t i = probe(k);
+			if (_used[i]) {
+				_values[i] = agg(_values[i], std::forward<X>(x));
+				return;
+			}
+			if ((_size + 1) * 2 > _used.size()) {
+				rehash(_used.size() * 2);
+				i = probe(k);
+			}
+			_used[i] = 1;
+			_keys[i] = std::move(k);
+			_values[i] = V(std::forward<X>(x));
+			++_size;
+		}
+
+		// fold the groups of from into these, with agg on two aggregates.
+		template <typename A>
+		void merge(GroupTable& from, A& agg) {
+			for (size_t i = 0; i < from._used.size(); ++i) {
+				if (from._used[i]) {
+					add(std::move(from._keys[i]), std::move(from._values[i]),
+							agg);
+				}
+			}
+		}
+
+		// the (key, aggregate) pairs, in no particular order.
+		struct Items {
+			typedef tuple<const K&, const V&> tuple_t;
+
+			const GroupTable* _t;
+			size_t            _i;
+
+			bool empty() const { return _i == _t->_used.size(); }
+			tuple_t front() const {
+				return tuple_t(_t->_keys[_i], _t->_values[_i]);
+			}
+			void pop_front() {
+				++_i;
+				skip();
+			}
+
+			void skip() {
+				while (not empty() and not _t->_used[_i]) {
+					++_i;
+				}
+			}
+		};
+
+		Items items() const {
+			Items r = {this, 0};
+			r.skip();
+			return r;
+		}
+
+	private:
+		H                          _hash;
+		size_t                     _size;
+		size_t                     _mask;
+		unsigned                   _shift;
+		std::vector<unsigned char> _used;
+		std::vector<K>             _keys;
+		std::vector<V>             _values;
+
+		size_t home(const K& k) const {
+			return details::fibonacci(_hash(k)) >> _shift;
+		}
+
+		// the slot of k, or the free one where it goes.
+		size_t probe(const K& k) const {
+			size_t i = home(k);
+			while (_used[i] and not (_keys[i] == k)) {
+				i = (i + 1) & _mask;
+			}
+			return i;
+		}
+
+		void rehash(size_t cap) {
+			std::vector<unsigned char> used(cap);
+			std::vector<K> keys(cap);
+			std::vector<V> values(cap);
+			used.swap(_used);
+			keys.swap(_keys);
+			values.swap(_values);
+			_mask = cap - 1;
+			_shift = 64 - details::log2_ceil(cap);
+			for (size_t i = 0; i < used.size(); ++i) {
+				if (used[i]) {
+					const size_t j = probe(keys[i]);
+					_used[j] = 1;
+					_keys[j] = std::move(keys[i]);
+					_values[j] = std::move(values[i]);
+				}
+			}
+		}
+};
+
+namespace details {
+
+	template <typename F, typename A, typename R>
+	struct group_types {
+		typedef typename std::decay<decltype(std::declval<F&>()(
+					std::declval<R&>().front()))>::type key_t;
+		typedef typename std::decay<decltype(std::declval<A&>()(
+					std::declval<R&>().front(),
+					std::declval<R&>().front()))>::type value_t;
+		typedef GroupTable<key_t, value_t> table_t;
+	};
+
+	template <typename R>
+	auto expected_groups(R& r) -> typename std::enable_if<
+		is_finite_range<R>::value, size_t>::type {
+		return std::min(size_t(r.size()), size_t(GROUP_BY_RESERVE));
+	}
+
+	template <typename R>
+	auto expected_groups(R&) -> typename std::enable_if<
+		not is_finite_range<R>::value, size_t>::type {
+		return 0;
+	}
+
+} // namespace details
+
+// the elements of r grouped by key(x), every group reduced by agg in the
+// order of r, like reduce() would: the first element of a group is its
+// initial aggregate. The table is pre-sized when r knows its size.
+template <typename F, typename A, typename R>
+auto group_by(F key, A agg, R r) -> typename std::enable_if<
+	not details::is_random_finite_range<R>::value,
+	typename details::group_types<F, A, R>::table_t>::type {
+	typename details::group_types<F, A, R>::table_t table(
+			details::expected_groups(r));
+	for (auto&& x: r) {
+		table.add(key(x), x, agg);
+	}
+	return table;
+}
+
+// random and finite: a partial table per chunk on the thread pool, merged
+// in order. So agg has to be associative and to take two aggregates.
+template <typename F, typename A, typename R>
+auto group_by(F key, A agg, R r) -> typename std::enable_if<
+	details::is_random_finite_range<R>::value,
+	typename details::group_types<F, A, R>::table_t>::type {
+	typedef typename details::group_types<F, A, R>::table_t table_t;
+
+	const size_t n = r.size();
+	thread_pool& pool = thread_pool::instance();
+	const size_t chunks = std::max(size_t(1),
+			std::min(pool.size() * 4, n / REDUCE_PAR_GRAIN));
+
+	std::vector<table_t> tables(chunks);
+	pool.parallel_for(chunks, [&](size_t c) {
+			F lf(key);
+			A la(agg);
+			R lr(r);
+			const size_t b = n * c / chunks;
+			const size_t e = n * (c + 1) / chunks;
+			table_t local(std::min(e - b, size_t(GROUP_BY_RESERVE)));
+			for (size_t i = b; i < e; ++i) {
+				auto&& x = lr[i];
+				local.add(lf(x), x, la);
+			}
+			tables[c] = std::move(local);
+		});
+
+	for (size_t c = 1; c < chunks; ++c) {
+		tables[0].merge(tables[c], agg);
+	}
+	return std::move(tables[0]);
+}
+
+namespace details {
+
+	// the build side of hash_join(), read only once built. The entries are
+	// sorted by bucket (the high bits of their hash) in three arrays:
+	// hashes, keys and values. starts[b] is the first entry of bucket b, so
+	// there is no pointer to chase and duplicated keys come for free.
+	template <typename K, typename V, typename H = std::hash<K>>
+	struct join_table {
+		typedef K key_t;
+		typedef V value_t;
+
+		H                     hash;
+		unsigned              shift;
+		std::vector<size_t>   starts;
+		std::vector<uint64_t> hashes;
+		std::vector<K>        keys;
+		std::vector<V>        values;
+
+		uint64_t hash_of(const K& k) const { return fibonacci(hash(k)); }
+		size_t bucket(uint64_t h) const { return h >> shift; }
+
+		template <typename F, typename R>
+		join_table(F key, R r) {
+			std::vector<K> ks;
+			std::vector<V> vs;
+			std::vector<uint64_t> hs;
+			for (auto&& x: r) {
+				vs.push_back(x);
+				ks.push_back(key(vs.back()));
+				hs.push_back(hash_of(ks.back()));
+			}
+
+			const size_t n = vs.size();
+			const unsigned bits = log2_ceil(n);
+			shift = 64 - bits;
+
+			// too big for the cache: first a radix pass on the high bits of
+			// the bucket, so the scatter into buckets stays within a
+			// partition. Either way, the entries end up in the same order.
+			const size_t bytes = n * (sizeof (K) + sizeof (V) + sizeof (uint64_t));
+			unsigned pbits = 0;
+			while (pbits < bits and pbits < 10
+					and (bytes >> pbits) > HASH_JOIN_PARTITION_BYTES) {
+				++pbits;
+			}
+			const size_t nparts = size_t(1) << pbits;
+			const unsigned lbits = bits - pbits;
+
+			std::vector<size_t> parted(n);
+			std::vector<size_t> pstarts(nparts + 1);
+			if (pbits) {
+				for (size_t i = 0; i < n; ++i) {
+					++pstarts[(hs[i] >> shift >> lbits) + 1];
+				}
+				for (size_t p = 0; p < nparts; ++p) {
+					pstarts[p + 1] += pstarts[p];
+				}
+				std::vector<size_t> pos(pstarts.begin(), pstarts.end() - 1);
+				for (size_t i = 0; i < n; ++i) {
+					parted[pos[hs[i] >> shift >> lbits]++] = i;
+				}
+			} else {
+				for (size_t i = 0; i < n; ++i) {
+					parted[i] = i;
+				}
+				pstarts[1] = n;
+			}
+
+			// then every partition, by bucket.
+			const size_t nlocal = size_t(1) << lbits;
+			const size_t lmask = nlocal - 1;
+			std::vector<size_t> order(n);
+			std::vector<size_t> pos(nlocal);
+			starts.assign((size_t(1) << bits) + 1, 0);
+			for (size_t p = 0; p < nparts; ++p) {
+				size_t* s = &starts[p * nlocal];
+				for (size_t j = pstarts[p]; j < pstarts[p + 1]; ++j) {
+					++s[(bucket(hs[parted[j]]) & lmask) + 1];
+				}
+				s[0] = pstarts[p];
+				for (size_t b = 0; b < nlocal; ++b) {
+					s[b + 1] += s[b];
+					pos[b] = s[b];
+				}
+				for (size_t j = pstarts[p]; j < pstarts[p + 1]; ++j) {
+					order[pos[bucket(hs[parted[j]]) & lmask]++] = parted[j];
+				}
+			}
+
+			hashes.reserve(n);
+			keys.reserve(n);
+			values.reserve(n);
+			for (size_t i: order) {
+				hashes.push_back(hs[i]);
+				keys.push_back(std::move(ks[i]));
+				values.push_back(std::move(vs[i]));
+			}
+		}
+	};
+
+} // namespace details
+
+// the pairs (b, p) of build and probe elements with equal keys, in the
+// order of the probe side, and for a given p in the order of the build
+// side. The build side is copied in a table once and shared by the copies
+// of the range. The probe side is streamed by batches: all the buckets of
+// a batch are fetched from memory at once, rather than one miss after the
+// other. The tuples reference the table and the batch, they are valid
+// until the next pop_front().
+template <typename T, typename P, typename F>
+struct HashJoin {
+	typedef typename T::key_t key_t;
+	typedef typename T::value_t build_t;
+	typedef typename std::decay<typename range_info<P>::type>::type probe_t;
+	typedef tuple<const build_t&, const probe_t&> tuple_t;
+
+	HashJoin(std::shared_ptr<const T> t, P p, F key):
+		_t(std::move(t)), _p(p), _key(key), _bi(0), _m(0), _me(0) {
+		_batch.reserve(HASH_JOIN_BATCH);
+		_keys.reserve(HASH_JOIN_BATCH);
+		_hashes.reserve(HASH_JOIN_BATCH);
+		refill();
+		find();
+	}
+
+	bool empty() const { return _bi == _batch.size(); }
+	tuple_t front() const { return tuple_t(_t->values[_m], _batch[_bi]); }
+
+	void pop_front() {
+		++_m;
+		find();
+	}
+
+	std::shared_ptr<const T> _t;
+	P                        _p;
+	F                        _key;
+	std::vector<probe_t>     _batch;
+	std::vector<key_t>       _keys;
+	std::vector<uint64_t>    _hashes;
+	size_t                   _bi;
+	size_t                   _m;
+	size_t                   _me;
+
+	// the next match, from entry _m of the bucket of _batch[_bi] on.
+	void find() {
+		while (_bi < _batch.size()) {
+			for (; _m < _me; ++_m) {
+				if (_t->hashes[_m] == _hashes[_bi] and _t->keys[_m] == _keys[_bi]) {
+					return;
+				}
+			}
+			if (++_bi == _batch.size()) {
+				refill();
+			} else {
+				enter();
+			}
+		}
+	}
+
+	void enter() {
+		const size_t b = _t->bucket(_hashes[_bi]);
+		_m = _t->starts[b];
+		_me = _t->starts[b + 1];
+	}
+
+	void refill() {
+		_batch.clear();
+		_keys.clear();
+		_hashes.clear();
+		_bi = 0;
+		for (; _batch.size() < HASH_JOIN_BATCH and not _p.empty();
+				_p.pop_front()) {
+			_batch.push_back(_p.front());
+			_keys.push_back(_key(_batch.back()));
+			_hashes.push_back(_t->hash_of(_keys.back()));
+			details::prefetch(&_t->starts[_t->bucket(_hashes.back())]);
+		}
+		// the bucket bounds are on their way, now the entries.
+		for (uint64_t h: _hashes) {
+			details::prefetch(_t->hashes.data() + _t->starts[_t->bucket(h)]);
+		}
+		if (not _batch.empty()) {
+			enter();
+		}
+	}
+};
+
+namespace details {
+
+	template <typename B, typename FB>
+	struct join_types {
+		typedef typename std::decay<decltype(std::declval<FB&>()(
+					std::declval<B&>().front()))>::type key_t;
+		typedef typename std::decay<
+			typename range_info<B>::type>::type value_t;
+		typedef join_table<key_t, value_t> table_t;
+	};
+
+} // namespace details
+
+// build is the side held in the table: pass the smaller input as build,
+// the sides are not swapped. probe_key(p) must compare and hash like
+// build_key(b): it is converted to the same type.
+template <typename B, typename P, typename FB, typename FP>
+HashJoin<typename details::join_types<B, FB>::table_t, P, FP> hash_join(
+		B build, P probe, FB build_key, FP probe_key) {
+	typedef typename details::join_types<B, FB>::table_t table_t;
+	return {std::make_shared<const table_t>(build_key, build), probe,
+		probe_key};
+}
+
+#endif /* ALGO_H */
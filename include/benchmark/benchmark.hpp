@@ -77,9 +77,21 @@ int main() { \
 	return 0; \
 }
 
+// the value escapes: the compiler has to assume it is read, so the work
+// producing it stays. An empty function, even noinline, is seen as pure
+// and elided along with that work. Taken by copy: the address of an
+// accumulator would pin it in memory for the whole loop.
 template <typename T>
-__attribute__((noinline))
-extern void BENCH_SWALLOW(const T&) {}
+inline void BENCH_SWALLOW(T v) {
+	asm volatile("" : : "g"(&v) : "memory");
+}
+
+// a scalar the compiler knows nothing about anymore, kept in a register:
+// a loop over it is not folded into a closed form.
+template <typename T>
+inline void BENCH_OPAQUE(T& v) {
+	asm volatile("" : "+r"(v));
+}
 
 #define BENCH_ASSERT(__X__) \
 	assert(__X__); \
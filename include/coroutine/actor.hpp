@@ -0,0 +1,160 @@
+/*
+ * actor.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef ACTOR_H
+#define ACTOR_H
+
+#include <atomic>
+#include <coroutine/scheduler.hpp>
+
+namespace coroutine {
+
+	// intrusive hook, messages derive from it. The link is never copied.
+	struct message {
+		std::atomic<message*> _next;
+
+		message() {}
+		message(const message&) {}
+		message& operator=(const message&) { return *this; }
+	};
+
+	// Dmitry Vyukov's intrusive multi producers, single consumer queue.
+	// push() is wait-free, pop() is lock-free but can return nullptr while a
+	// push is half done (empty() then returns false).
+	class mailbox {
+		public:
+			mailbox(): _head(&_stub), _tail(&_stub) {
+				_stub._next.store(nullptr, std::memory_order_relaxed);
+			}
+
+			mailbox(const mailbox&) = delete;
+			mailbox& operator=(const mailbox&) = delete;
+
+			// any thread.
+			void push(message* m) {
+				m->_next.store(nullptr, std::memory_order_relaxed);
+				message* prev = _head.exchange(m, std::memory_order_acq_rel);
+				prev->_next.store(m, std::memory_order_release);
+			}
+
+			// consumer only.
+			message* pop() {
+				message* tail = _tail;
+				message* next = tail->_next.load(std::memory_order_acquire);
+				if (tail == &_stub) {
+					if (not next)
+						return nullptr;
+					_tail = next;
+					tail = next;
+					next = next->_next.load(std::memory_order_acquire);
+				}
+				if (next) {
+					_tail = next;
+					return tail;
+				}
+				if (tail != _head.load(std::memory_order_acquire))
+					return nullptr;
+				push(&_stub);
+				next = tail->_next.load(std::memory_order_acquire);
+				if (next) {
+					_tail = next;
+					return tail;
+				}
+				return nullptr;
+			}
+
+			// consumer only.
+			bool empty() const {
+				return _tail == &_stub
+					and _head.load(std::memory_order_acquire) == &_stub;
+			}
+
+		private:
+			std::atomic<message*> _head;
+			message*              _tail;
+			message               _stub;
+	};
+
+	/*
+	 * An actor is a task of a scheduler, running:
+	 *
+	 *   void f(yielder<void (M*)> receive, M* first_message);
+	 *
+	 * receive() returns the next message, the task is parked as long as the
+	 * mailbox is empty, and woken up only by the post() that makes it
+	 * non-empty. Up to batch messages are handled per resume, without any
+	 * switch, before giving the hand back to the other tasks. The actor
+	 * terminates when f returns. The messages are owned by the actor, and
+	 * the actor object has to outlive its task.
+	 *
+	 * CONFIGS are given to the coroutine builder, think about a little stack
+	 * (ie: stack::size_in_kb<16>) if you plan to have millions of them.
+	 */
+	template <typename M, typename... CONFIGS>
+		class actor {
+			public:
+				typedef yielder<void (M*)> yielder_t;
+
+				template <typename F>
+					actor(scheduler& s, F f, size_t batch = 64):
+						_scheduled(true), _batch(batch), _budget(batch)
+				{
+					_task = &s.template spawn<CONFIGS...>([this, f] () mutable {
+							M* first = receive();
+							f(yielder_t(&receive_trampoline, this), first);
+						});
+				}
+
+				actor(const actor&) = delete;
+				actor& operator=(const actor&) = delete;
+
+				// any thread.
+				void post(M* m) {
+					_mailbox.push(m);
+					if (not _scheduled.exchange(true))
+						_task->owner().wake(*_task);
+				}
+
+			private:
+				mailbox           _mailbox;
+				std::atomic<bool> _scheduled;
+				task*             _task;
+				const size_t      _batch;
+				size_t            _budget;
+
+				static M* receive_trampoline(void* self) {
+					return reinterpret_cast<actor*>(self)->receive();
+				}
+
+				M* receive() {
+					for (;;) {
+						if (not _budget) {
+							// let the others run, we stay scheduled.
+							_budget = _batch;
+							scheduler::yield();
+						}
+						if (message* m = _mailbox.pop()) {
+							--_budget;
+							return static_cast<M*>(m);
+						}
+						_scheduled.store(false);
+						if (not _mailbox.empty()
+								and not _scheduled.exchange(true)) {
+							// a producer is in the middle of a push.
+							scheduler::yield();
+							continue;
+						}
+						// the producer who set _scheduled will wake us up.
+						_budget = _batch;
+						scheduler::park();
+					}
+				}
+		};
+
+} // namespace coroutine
+
+#endif /* ACTOR_H */
@@ -0,0 +1,138 @@
+/*
+ * any_coroutine.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef ANY_COROUTINE_H
+#define ANY_COROUTINE_H
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <coroutine/builder.hpp>
+
+/*
+ * Every functor given to coro() instantiates its own coroutine<S, F, CONTEXT>,
+ * with its own bootstrap, enter and swapcontext. any_coroutine<S> instead
+ * always instantiates coroutine<S, details::erased_func<S>, CONTEXT>: the
+ * functor lives on the heap and is called trough a function pointer, so
+ * there is one switch path per signature (and CONFIGS) in the whole program.
+ *
+ * It is a handle, it can be moved (even while running) and put in a
+ * container along with any other coroutine of the same signature.
+ *
+ *   std::vector<any_coroutine<int ()> > gens;
+ *   gens.emplace_back([](yielder<int ()> yield) { yield(1); return 2; });
+ */
+
+namespace coroutine {
+
+	namespace details {
+
+		template <typename S, typename Y = yielder<S> >
+			class erased_func;
+
+		template <typename RV, typename... ARGS, typename Y>
+			class erased_func<RV (ARGS...), Y> {
+				typedef Y yielder_t;
+
+			public:
+				template <typename F>
+					explicit erased_func(F f):
+						_func(new F(std::move(f))),
+						_invoke(&invoke<F>),
+						_destroy(&destroy<F>)
+				{}
+
+				erased_func(erased_func&& from):
+					_func(from._func),
+					_invoke(from._invoke),
+					_destroy(from._destroy)
+				{
+					from._func = nullptr;
+				}
+
+				erased_func(const erased_func&) = delete;
+				erased_func& operator=(const erased_func&) = delete;
+
+				~erased_func() {
+					if (_func)
+						_destroy(_func);
+				}
+
+				RV operator ()(yielder_t yield, ARGS... args) {
+					return _invoke(_func, yield, args...);
+				}
+
+			private:
+				void* _func;
+				RV  (*_invoke)(void*, yielder_t, ARGS...);
+				void (*_destroy)(void*);
+
+				template <typename F>
+					static RV invoke(void* f, yielder_t yield, ARGS... args) {
+						return (*static_cast<F*>(f))(yield, args...);
+					}
+
+				template <typename F>
+					static void destroy(void* f) {
+						delete static_cast<F*>(f);
+					}
+		};
+
+	} // namespace details
+
+	template <typename S, typename... CONFIGS>
+		class any_coroutine {
+			typedef typename details::decay_sign<S>::type sign_t;
+			typedef typename
+				details::find_if<kind::is, CONFIGS..., kind::stackful>::type
+				kind_tag;
+			typedef details::erased_func<sign_t,
+				typename kind::select_yielder<kind_tag, sign_t>::type> func_t;
+
+		public:
+			// the one coroutine type shared by every functor.
+			typedef typename builder<S, func_t, CONFIGS...>::type impl_type;
+
+			any_coroutine() {}
+
+			template <typename F, typename = typename std::enable_if<
+				not std::is_same<F, any_coroutine>::value>::type>
+				any_coroutine(F f):
+					_impl(new impl_type(func_t(std::move(f)))) {}
+
+			any_coroutine(any_coroutine&& from):
+				_impl(std::move(from._impl)) {}
+
+			any_coroutine& operator=(any_coroutine&& from) {
+				_impl = std::move(from._impl);
+				return *this;
+			}
+
+			any_coroutine(const any_coroutine&) = delete;
+			any_coroutine& operator=(const any_coroutine&) = delete;
+
+			template <typename... ARGS>
+				auto operator ()(ARGS&&... args)
+				-> decltype(std::declval<impl_type&>()(
+							std::forward<ARGS>(args)...)) {
+					return (*_impl)(std::forward<ARGS>(args)...);
+				}
+
+			// false once terminated, or if empty.
+			operator bool() const {
+				return _impl and bool(*_impl);
+			}
+
+			impl_type& get() { return *_impl; }
+
+		private:
+			std::unique_ptr<impl_type> _impl;
+		};
+
+} // namespace coroutine
+
+#endif /* ANY_COROUTINE_H */
@@ -9,6 +9,7 @@
 #define BUILDER_H
 
 #include <coroutine/coroutine.hpp>
+#include <coroutine/stackless.hpp>
 #include <coroutine/best_context.hpp>
 #include <functional>
 
@@ -103,7 +104,13 @@ namespace coroutine {
 			typedef stack::stack<stack_tag, stack_size> stack_type;
 			typedef context::context<context_tag, stack_type> context_type;
 
-			typedef coroutine<sign_t, func_t, context_type> type;
+			typedef typename
+				details::find_if<kind::is, CONFIGS..., kind::stackful>::type
+				kind_tag;
+
+			typedef typename
+				kind::select<kind_tag, sign_t, func_t, context_type>::type
+				type;
 		};
 
 
@@ -0,0 +1,114 @@
+/*
+ * call_with_stack.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef CALL_WITH_STACK_H
+#define CALL_WITH_STACK_H
+
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <coroutine/best_context.hpp>
+#include <coroutine/impl/stack_pooled.hpp>
+
+namespace coroutine {
+
+	namespace details {
+
+		// where the result of the function is stored, while we are still on
+		// the big stack.
+		template <typename R>
+			struct call_result {
+				typename std::aligned_storage<sizeof (R),
+						 std::alignment_of<R>::value>::type _storage;
+
+				template <typename F>
+					void run(F& f) { new (&_storage) R(f()); }
+
+				R get() {
+					R& r = *reinterpret_cast<R*>(&_storage);
+					R v(std::move(r));
+					r.~R();
+					return v;
+				}
+			};
+
+		template <typename R>
+			struct call_result<R&> {
+				R* _ptr;
+
+				template <typename F>
+					void run(F& f) { _ptr = &f(); }
+
+				R& get() { return *_ptr; }
+			};
+
+		template <>
+			struct call_result<void> {
+				template <typename F>
+					void run(F& f) { f(); }
+
+				void get() {}
+			};
+
+		template <typename R, typename F>
+			struct stack_call {
+				F&                 _f;
+				call_result<R>     _result;
+				std::exception_ptr _exception;
+
+				static void trampoline(void* self) {
+					reinterpret_cast<stack_call*>(self)->run();
+				}
+
+				void run() {
+					try {
+						_result.run(_f);
+					} catch(...) {
+						_exception = std::current_exception();
+					}
+				}
+			};
+
+		template <typename R, typename F>
+			R call_with_stack(size_t size, F& f)
+			{
+				typedef typename context::resolve_alias<context::best>::type
+					context_tag;
+				typedef stack::stack<stack::pooled, 0> stack_t;
+
+				stack_call<R, F> call{f, {}, nullptr};
+				context::context<context_tag, stack_t> ctx(
+						&stack_call<R, F>::trampoline, &call, stack_t(size));
+				// returns once the function is done.
+				ctx.enter();
+
+				if (call._exception)
+					std::rethrow_exception(call._exception);
+				return call._result.get();
+			}
+
+	} // namespace details
+
+	// call f(args...) on a stack of (at least) size bytes, taken from a per
+	// thread pool, and come back with its result. Any exception is
+	// re-thrown on the caller side, just like coroutine::enter() does.
+	// Nothing is copied, arguments are forwarded as is.
+	template <typename F, typename... ARGS>
+		auto call_with_stack(size_t size, F f, ARGS&&... args)
+		-> decltype(f(std::forward<ARGS>(args)...))
+		{
+			typedef decltype(f(std::forward<ARGS>(args)...)) result_t;
+			auto call = [&]() -> result_t {
+				return f(std::forward<ARGS>(args)...);
+			};
+			return details::call_with_stack<result_t>(size, call);
+		}
+
+} // namespace coroutine
+
+#endif /* CALL_WITH_STACK_H */
@@ -8,7 +8,10 @@
 #ifndef COROUTINE_H
 #define COROUTINE_H
 
+#include <exception>
+#include <utility>
 #include <coroutine/context.hpp>
+#include <coroutine/fls.hpp>
 #include <coroutine/yielder.hpp>
 
 
@@ -68,28 +71,94 @@ namespace coroutine {
 	template <typename RV, typename IMPL>
 		class coroutine_base<RV (), IMPL>
 		{
+			friend class yielder<RV ()>;
+
 			public:
 				RV operator ()()
 				{
-					static_cast<IMPL*>(this)->enter();
-					return *_rv;
+					typename details::delegation<RV>::scope scope(_delegation);
+					for (;;) {
+						RV* value = nullptr;
+						if (_delegation.empty()) {
+							value = resume();
+						} else {
+							// the last delegate threw: resume() throws it
+							// from our own from().
+							try {
+								value = _delegation.resume_top();
+							} catch (...) {
+								_thrown = std::current_exception();
+							}
+						}
+						if (value)
+							return *value;
+					}
 				}
 
 			protected:
 				void bootstrap()
 				{
 					yield_final(static_cast<IMPL*>(this)->_func(
-								yielder<RV ()>(&yield_trampoline, this)
+								yielder<RV ()>(&yield_trampoline, this,
+									&delegate_trampoline)
 								));
 				}
 
 			private:
-				RV* _rv;
+				RV*                      _rv;
+				bool                     _delegated;
+				details::delegation<RV> _delegation;
+				std::exception_ptr       _thrown;
+
+				RV* resume()
+				{
+					_delegated = false;
+					static_cast<IMPL*>(this)->enter();
+					return _delegated ? nullptr : _rv;
+				}
+
+				details::delegate<RV> as_delegate()
+				{
+					return { this, &resume_trampoline, &alive_trampoline,
+						&fail_trampoline, &_delegation };
+				}
+
+				static RV* resume_trampoline(void* self) {
+					return reinterpret_cast<coroutine_base*>(self)->resume();
+				}
+
+				static bool alive_trampoline(void* self) {
+					return bool(*static_cast<IMPL*>(
+								reinterpret_cast<coroutine_base*>(self)));
+				}
+
+				static void fail_trampoline(void* self, std::exception_ptr e) {
+					reinterpret_cast<coroutine_base*>(self)->_thrown = e;
+				}
 
 				static void yield_trampoline(void* self, RV value) {
 					reinterpret_cast<coroutine_base*>(self)->yield(value);
 				}
 
+				static void delegate_trampoline(void* self,
+						const details::delegate<RV>& d) {
+					reinterpret_cast<coroutine_base*>(self)->delegate(d);
+				}
+
+				// push on the delegation stack of the outermost coroutine,
+				// and let it resume the delegate in place of us.
+				void delegate(const details::delegate<RV>& d)
+				{
+					details::delegation<RV>::active()->push(d);
+					_delegated = true;
+					static_cast<IMPL*>(this)->leave();
+					if (_thrown) {
+						std::exception_ptr e = _thrown;
+						_thrown = nullptr;
+						std::rethrow_exception(e);
+					}
+				}
+
 				void yield(RV value)
 				{
 					_rv = &value;
@@ -189,7 +258,7 @@ namespace coroutine {
 
 			coroutine(func_t f):
 				_context(&bootstrap_trampoline, this),
-				_func(f),
+				_func(std::move(f)),
 				_exception(nullptr),
 				_state(INITIALIZED)
 			{}
@@ -213,10 +282,12 @@ namespace coroutine {
 			// only if the coroutine can be moved
 			// without any trouble.
 			coroutine(coroutine&& from):
+				base_t(std::move(from)),
 				_context(std::move(from._context)),
 				_func(std::move(from._func)),
 				_exception(nullptr),
-				_state(INITIALIZED)
+				_state(INITIALIZED),
+				_fls(std::move(from._fls))
 			{
 				std::cout << "coroutine: move" << std::endl;
 				if (from._state == RUNNING)
@@ -229,11 +300,20 @@ namespace coroutine {
 				return _state != TERMINATED;
 			}
 
+			// release the memory of the stack below the point where the
+			// coroutine is suspended. A coroutine that once recursed deeply
+			// keeps every touched page otherwise.
+			size_t trim_stack(
+					stack::trim_advice advice = stack::trim_dontneed) {
+				return _context.trim(advice);
+			}
+
 		private:
 			context_t          _context;
 			func_t             _func;
 			std::exception_ptr _exception;
 			state_t            _state;
+			details::fls       _fls;
 
 			static void bootstrap_trampoline(void* self) {
 					reinterpret_cast<coroutine*>(self)
@@ -253,7 +333,9 @@ namespace coroutine {
 			void enter() {
 				if (_state == TERMINATED)
 					throw std::runtime_error("terminated coroutine");
+				details::fls* const prev_fls = details::fls::swap_current(&_fls);
 				_context.enter();
+				details::fls::restore_current(prev_fls);
 				// throw if caught any exception inside the coroutine.
 				if (_exception)
 					std::rethrow_exception(_exception);
@@ -0,0 +1,101 @@
+/*
+ * delegate.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef DELEGATE_H
+#define DELEGATE_H
+
+#include <exception>
+#include <vector>
+
+/*
+ * "yield from" support for RV () coroutines.
+ *
+ * When a coroutine delegates to a sub-coroutine, the sub-coroutine is pushed
+ * on the delegation stack of the outermost coroutine, the one called by the
+ * consumer. The consumer then resumes the top of this stack directly, so
+ * producing a value costs one context switch whatever the depth of the
+ * delegation chain. The top is popped as soon as it terminated, giving back
+ * the hand to the coroutine below it. If it terminated by throwing, the
+ * exception is thrown by the from() of the coroutine below it instead.
+ *
+ * The delegation stack of the outermost coroutine is the "active" one for
+ * the current thread while the consumer is inside its operator().
+ */
+
+namespace coroutine {
+	namespace details {
+
+		template <typename RV>
+			struct delegation;
+
+		template <typename RV>
+			struct delegate {
+				void* coro;
+				// resume the coroutine. Return a pointer to the produced value,
+				// or nullptr if the coroutine delegated in turn.
+				RV* (*resume)(void*);
+				bool (*alive)(void*);
+				// throw e out of the from() the coroutine is suspended in.
+				void (*fail)(void*, std::exception_ptr e);
+				// delegations the coroutine started on its own, before being
+				// delegated to.
+				delegation<RV>* pending;
+			};
+
+		template <typename RV>
+			struct delegation {
+				std::vector<delegate<RV> > stack;
+
+				bool empty() const { return stack.empty(); }
+
+				void push(const delegate<RV>& d) {
+					stack.push_back(d);
+					std::vector<delegate<RV> >& p = d.pending->stack;
+					stack.insert(stack.end(), p.begin(), p.end());
+					p.clear();
+				}
+
+				// resume the innermost delegate. Return nullptr when no value
+				// was produced, either because the delegate terminated (and is
+				// popped) or because it delegated further. A delegate throwing
+				// is popped too, and its exception handed to the one below it;
+				// or thrown to the outermost coroutine, at the bottom.
+				RV* resume_top() {
+					delegate<RV> d = stack.back();
+					if (not d.alive(d.coro)) {
+						stack.pop_back();
+						return nullptr;
+					}
+					try {
+						return d.resume(d.coro);
+					} catch (...) {
+						stack.pop_back();
+						if (stack.empty())
+							throw;
+						stack.back().fail(stack.back().coro,
+								std::current_exception());
+						return nullptr;
+					}
+				}
+
+				static delegation*& active() {
+					static thread_local delegation* d = nullptr;
+					return d;
+				}
+
+				struct scope {
+					delegation* prev;
+
+					scope(delegation& d): prev(active()) { active() = &d; }
+					~scope() { active() = prev; }
+				};
+			};
+
+	} // namespace details
+} // namespace coroutine
+
+#endif /* DELEGATE_H */
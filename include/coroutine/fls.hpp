@@ -0,0 +1,169 @@
+/*
+ * fls.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef FLS_H
+#define FLS_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+/*
+ * Fiber local storage.
+ *
+ * Every coroutine owns a little array of slots (allocated on first use),
+ * and a thread local pointer designates the one of the coroutine currently
+ * running. It is swapped by enter(), so a coroutine sees its own values
+ * whatever the thread it runs on, and whatever the coroutines interleaved
+ * with it. Outside of any coroutine, the slots of the thread are used.
+ *
+ * Keys are fiber_local<T> objects, meant to be declared once at namespace
+ * scope. Each of them registers a slot index at static initialisation, and
+ * an access is then: load the thread local pointer, index the array.
+ */
+
+#ifndef CORO_FLS_MAX_SLOTS
+#	define CORO_FLS_MAX_SLOTS 16
+#endif
+
+namespace coroutine {
+
+	namespace details {
+
+		class fls {
+			public:
+				static const size_t max_slots = CORO_FLS_MAX_SLOTS;
+				typedef void (*deleter_t)(void*);
+
+				fls(): _slots(nullptr) {}
+
+				fls(fls&& from): _slots(from._slots) {
+					from._slots = nullptr;
+				}
+
+				fls(const fls&) = delete;
+				fls& operator=(const fls&) = delete;
+
+				~fls() {
+					if (not _slots)
+						return;
+					for (size_t i = 0; i < max_slots; ++i)
+						if (_slots[i])
+							deleters()[i](_slots[i]);
+					delete [] _slots;
+				}
+
+				void* get(size_t slot) const {
+					return _slots ? _slots[slot] : nullptr;
+				}
+
+				// take ownership of value.
+				void set(size_t slot, void* value) {
+					if (not _slots)
+						_slots = new void*[max_slots]();
+					if (_slots[slot])
+						deleters()[slot](_slots[slot]);
+					_slots[slot] = value;
+				}
+
+				static size_t register_slot(deleter_t deleter) {
+					static std::atomic<size_t> next(0);
+					const size_t slot = next++;
+					if (slot >= max_slots)
+						throw std::length_error(
+								"too many fiber_local, see CORO_FLS_MAX_SLOTS");
+					deleters()[slot] = deleter;
+					return slot;
+				}
+
+				static fls& current() {
+					fls* c = current_ref();
+					return c ? *c : thread_slots();
+				}
+
+				// make f the current one, return the previous one.
+				static fls* swap_current(fls* f) {
+					fls* prev = current_ref();
+					current_ref() = f;
+					return prev;
+				}
+
+				static void restore_current(fls* prev) {
+					current_ref() = prev;
+				}
+
+			private:
+				void** _slots;
+
+				static fls*& current_ref() {
+					static thread_local fls* c = nullptr;
+					return c;
+				}
+
+				static fls& thread_slots() {
+					static thread_local fls f;
+					return f;
+				}
+
+				static deleter_t* deleters() {
+					static deleter_t d[max_slots];
+					return d;
+				}
+		};
+
+	} // namespace details
+
+	// one value of type T per coroutine (and per thread outside of them).
+	template <typename T>
+		class fiber_local {
+			public:
+				fiber_local(): _slot(details::fls::register_slot(&destroy)) {}
+
+				fiber_local(const fiber_local&) = delete;
+				fiber_local& operator=(const fiber_local&) = delete;
+
+				// nullptr if never set in the running coroutine.
+				T* get() const {
+					return static_cast<T*>(details::fls::current().get(_slot));
+				}
+
+				void set(const T& value) {
+					if (T* v = get())
+						*v = value;
+					else
+						details::fls::current().set(_slot, new T(value));
+				}
+
+				void reset() {
+					details::fls::current().set(_slot, nullptr);
+				}
+
+				// default constructed on first access.
+				T& operator*() const {
+					if (T* v = get())
+						return *v;
+					T* v = new T();
+					details::fls::current().set(_slot, v);
+					return *v;
+				}
+
+				T* operator->() const { return &**this; }
+
+				fiber_local& operator=(const T& value) {
+					set(value);
+					return *this;
+				}
+
+			private:
+				const size_t _slot;
+
+				static void destroy(void* v) { delete static_cast<T*>(v); }
+		};
+
+} // namespace coroutine
+
+#endif /* FLS_H */
@@ -0,0 +1,57 @@
+/*
+ * generator.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <type_traits>
+#include <utility>
+#include <tools.hpp>
+
+namespace coroutine {
+
+	// look at any RV () coroutine (stackful or stackless) as a forward range.
+	// Every value yielded, and the final returned value, are part of the
+	// range. The generator is referenced, not copied: it has to outlive the
+	// range.
+	template <typename G>
+		class generator_range {
+			public:
+				typedef typename std::remove_reference<
+					decltype(std::declval<G&>()())>::type value_type;
+
+				generator_range(G& g): _g(&g), _empty(false) {
+					pop_front();
+				}
+
+				bool empty() const { return _empty; }
+
+				void pop_front() {
+					if (*_g)
+						_front = (*_g)();
+					else
+						_empty = true;
+				}
+
+				const value_type& front() const { return _front; }
+
+				// for(:) statement, the free ones are not found by ADL.
+				range_iterator<generator_range> begin() { return *this; }
+				range_iterator<generator_range> end() { return *this; }
+
+			private:
+				G*         _g;
+				value_type _front;
+				bool       _empty;
+		};
+
+	template <typename G>
+		generator_range<G> as_range(G& g) { return g; }
+
+} // namespace coroutine
+
+#endif /* GENERATOR_H */
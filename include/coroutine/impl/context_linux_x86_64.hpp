@@ -9,6 +9,8 @@
 #define CONTEXT_LINUX_X86_64_H
 
 #include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <coroutine/stack.hpp>
 #include <coroutine/context.hpp>
 #include <coroutine/impl/stack_static.hpp>
@@ -43,6 +45,10 @@ namespace coroutine {
 				context(function_t* f, void* arg):
 					_f(f), _arg(arg) { reset(); }
 
+				// run on a stack built by the caller (ie: with a runtime size).
+				context(function_t* f, void* arg, stack_t&& stack):
+					_f(f), _arg(arg), _stack(std::move(stack)) { reset(); }
+
 				context(const context& from) = delete;
 				context& operator=(const context& from) = delete;
 				context& operator=(context&& from) = delete;
@@ -75,7 +81,7 @@ namespace coroutine {
 					*--_sp = (void*)this; // trampoline arg1 is aligned.
 					*--_sp = 0; // and trampoline return addr is not.
 
-					_sp -= 2;                    // hack space
+					_sp -= 16;                   // red zone skipped by swapcontext
 					*--_sp = (void*)&trampoline; // next instruction addr
 					--_sp;                       // rbp
 				}
@@ -98,6 +104,39 @@ namespace coroutine {
 #endif // CORO_LINUX_8664_2SWAPSITE
 				}
 
+				// give back to the system the pages of the stack under the
+				// saved stack pointer, return how many bytes. While the
+				// context is running, _sp holds the stack pointer of the
+				// caller, outside of our stack, and nothing is done.
+				size_t trim(stack::trim_advice advice)
+				{
+					char* const base = _stack.get_stack_ptr();
+					char* const sp = reinterpret_cast<char*>(_sp);
+					if (not base or sp <= base or sp > base + _stack.get_size())
+						return 0;
+
+					const uintptr_t page = ::sysconf(_SC_PAGESIZE);
+					char* const b = reinterpret_cast<char*>(
+							(reinterpret_cast<uintptr_t>(base) + page - 1)
+							& ~(page - 1));
+					char* const e = reinterpret_cast<char*>(
+							reinterpret_cast<uintptr_t>(sp) & ~(page - 1));
+					if (e <= b)
+						return 0;
+
+					int adv = MADV_DONTNEED;
+#ifdef    MADV_FREE
+					if (advice == stack::trim_free)
+						adv = MADV_FREE;
+#endif // MADV_FREE
+					if (::madvise(b, e - b, adv) != 0) {
+						if (adv == MADV_DONTNEED
+								or ::madvise(b, e - b, MADV_DONTNEED) != 0)
+							return 0;
+					}
+					return e - b;
+				}
+
 				static const char* getImplName() { return "linux x86_64"; }
 
 			private:
@@ -146,18 +185,22 @@ namespace coroutine {
 						 */
 
 						asm volatile (
-								/* allocate some space... just because
-								 * compilers seem to use the stack under rsp
-								 * when rsp is not aligned. Because I cant
-								 * know if I am playing with an aligned
-								 * stack or not and I want to keep the same
-								 * one I reserve 16 bytes.
+								/* skip the red zone. The System V ABI let
+								 * leaf functions use the 128 bytes under
+								 * rsp without moving it, and the compiler
+								 * has no idea that we push things there.
+								 * Because I want to keep the same layout
+								 * on both sides, I always reserve the
+								 * whole 128 bytes.
 								 */
 
-								"sub $16, %%rsp\n\t"
+								"sub $128, %%rsp\n\t"
 
-								// store next instruction
-								"push $1f\n\t"
+								// store next instruction (rip relative,
+								// so it links in position independent
+								// executables too).
+								"lea 1f(%%rip), %%rax\n\t"
+								"push %%rax\n\t"
 
 								// store registers
 								"push %%rbp\n\t"
@@ -172,7 +215,7 @@ namespace coroutine {
 								"pop %%rax\n\t"
 
 								// release the little space.
-								"add $16, %%rsp\n\t"
+								"add $128, %%rsp\n\t"
 
 								// jump to next instruction
 								"jmp *%%rax\n\t"
@@ -39,6 +39,11 @@ namespace coroutine {
 					context(function_t* f, void* arg):
 						_f(f), _arg(arg) { reset(); }
 
+					// run on a stack built by the caller (ie: with a runtime
+					// size).
+					context(function_t* f, void* arg, stack_t&& stack):
+						_f(f), _arg(arg), _stack(std::move(stack)) { reset(); }
+
 					context(const context& from) = delete;
 					context& operator=(const context& from) = delete;
 					context& operator=(context&& from) = delete;
@@ -79,6 +84,10 @@ namespace coroutine {
 							error(__PRETTY_FUNCTION__, "swapcontext failed");
 					}
 
+					// the saved stack pointer is hidden inside the ucontext,
+					// so there is nothing we can trim here.
+					size_t trim(stack::trim_advice) { return 0; }
+
 					static const char* get_impl_name() { return "posix"; }
 
 				private:
@@ -0,0 +1,145 @@
+/*
+ * stack_pooled.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef STACK_POOLED_H
+#define STACK_POOLED_H
+
+#include <new>
+#include <stdexcept>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <coroutine/stack.hpp>
+
+namespace coroutine {
+	namespace stack {
+
+		// mmap'ed stacks, with a guard page at the bottom, recycled trough a
+		// little per thread pool. The size can be chosen at runtime, SSIZE
+		// is only the size used by the default constructor.
+		struct pooled: stack_tag {
+			static const bool really_moveable = true;
+		};
+
+		namespace details {
+
+			class stack_pool {
+				public:
+					// number of free stacks kept around per thread.
+					static const size_t max_free = 4;
+
+					static size_t page_size() {
+						static const size_t size = ::sysconf(_SC_PAGESIZE);
+						return size;
+					}
+
+					static size_t round_size(size_t size) {
+						const size_t page = page_size();
+						return (size + page - 1) / page * page;
+					}
+
+					// return a stack of at least size bytes (rounded up to
+					// the page size), guard page excluded.
+					static char* acquire(size_t& size) {
+						size = round_size(size);
+						std::vector<entry>& free = instance()._free;
+						for (size_t i = 0; i < free.size(); ++i) {
+							if (free[i].size >= size) {
+								char* ptr = free[i].ptr;
+								size = free[i].size;
+								free.erase(free.begin() + i);
+								return ptr;
+							}
+						}
+						return allocate(size);
+					}
+
+					static void release(char* ptr, size_t size) {
+						std::vector<entry>& free = instance()._free;
+						if (free.size() < max_free)
+							free.push_back(entry{ptr, size});
+						else
+							deallocate(ptr, size);
+					}
+
+				private:
+					struct entry {
+						char*  ptr;
+						size_t size;
+					};
+
+					std::vector<entry> _free;
+
+					~stack_pool() {
+						for (const entry& e: _free)
+							deallocate(e.ptr, e.size);
+					}
+
+					static stack_pool& instance() {
+						static thread_local stack_pool pool;
+						return pool;
+					}
+
+					static char* allocate(size_t size) {
+						const size_t page = page_size();
+						void* p = ::mmap(0, size + page,
+								PROT_READ | PROT_WRITE,
+								MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+								-1, 0);
+						if (p == MAP_FAILED)
+							throw std::bad_alloc();
+						if (::mprotect(p, page, PROT_NONE) != 0) {
+							::munmap(p, size + page);
+							throw std::runtime_error("mprotect: guard page");
+						}
+						return static_cast<char*>(p) + page;
+					}
+
+					static void deallocate(char* ptr, size_t size) {
+						const size_t page = page_size();
+						::munmap(ptr - page, size + page);
+					}
+			};
+
+		} // namespace details
+
+		template <size_t SSIZE>
+			class stack<pooled, SSIZE> {
+				public:
+					stack(): _size(SSIZE) {
+						_stack = details::stack_pool::acquire(_size);
+					}
+
+					explicit stack(size_t size): _size(size) {
+						_stack = details::stack_pool::acquire(_size);
+					}
+
+					~stack() {
+						if (_stack)
+							details::stack_pool::release(_stack, _size);
+					}
+
+					stack(const stack& from) = delete;
+					stack& operator=(const stack& from) = delete;
+					stack& operator=(stack&& from) = delete;
+
+					stack(stack&& from): _stack(from._stack), _size(from._size) {
+						from._stack = 0;
+					}
+
+					size_t get_size() const { return _size; }
+					char* get_stack_ptr() { return _stack; }
+
+				private:
+					char*  _stack;
+					size_t _size;
+			};
+
+	} // namespace stack
+} // namespace coroutine
+
+#endif /* STACK_POOLED_H */
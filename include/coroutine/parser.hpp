@@ -0,0 +1,225 @@
+/*
+ * parser.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <stdint.h>
+#include <coroutine/builder.hpp>
+
+/*
+ * Push parsers.
+ *
+ * A parser is a coroutine<void (slice)>: the network (or file) layer feeds
+ * it the buffers as they come, the parser runs until it needs more bytes
+ * and is suspended right there. Nothing is re-scanned, and nothing is
+ * buffered unless a token straddles two buffers. An empty slice marks the
+ * end of the stream.
+ *
+ *   auto p = make_parser(decoder::lines([](slice line) { ... }));
+ *   while ((n = read(fd, buf, sizeof buf)) > 0)
+ *       p(slice(buf, n));
+ *   p(slice());
+ *
+ * The parser itself is a plain function of a reader:
+ *
+ *   void f(reader& in);
+ *
+ * Slices returned by the reader point either in the buffer being fed or
+ * in the reader, they are valid until the next call on the reader.
+ */
+
+namespace coroutine {
+
+	struct slice {
+		const char* data;
+		size_t      size;
+
+		slice(): data(nullptr), size(0) {}
+		slice(const char* d, size_t s): data(d), size(s) {}
+		slice(const std::string& s): data(s.data()), size(s.size()) {}
+
+		bool empty() const { return size == 0; }
+		const char* begin() const { return data; }
+		const char* end() const { return data + size; }
+		char operator[](size_t i) const { return data[i]; }
+		std::string str() const { return std::string(data, size); }
+
+		slice sub(size_t from, size_t n) const {
+			return slice(data + from, n);
+		}
+	};
+
+	class reader {
+		public:
+			typedef yielder<void (slice)> yielder_t;
+
+			reader(yielder_t yield, slice first):
+				_yield(yield), _in(first), _eof(first.empty()) {}
+
+			reader(const reader&) = delete;
+			reader& operator=(const reader&) = delete;
+
+			// wait for some bytes, false at the end of the stream.
+			bool more() {
+				while (_in.empty())
+					if (not fill())
+						return false;
+				return true;
+			}
+
+			// the next n bytes, throw if the stream ends before.
+			slice take(size_t n) {
+				if (_in.size >= n)
+					return consume(n);
+				_buf.assign(_in.data, _in.size);
+				consume(_in.size);
+				while (_buf.size() < n) {
+					if (not fill())
+						throw std::runtime_error("parser: truncated input");
+					const size_t k = std::min(n - _buf.size(), _in.size);
+					_buf.append(_in.data, k);
+					consume(k);
+				}
+				return slice(_buf);
+			}
+
+			// the bytes up to delim (excluded), delim is consumed. At the end
+			// of the stream, whatever is left.
+			slice take_until(char delim) {
+				if (const char* p = find(delim))
+					return consume_through(p);
+				_buf.assign(_in.data, _in.size);
+				consume(_in.size);
+				while (fill()) {
+					// only the new bytes are scanned.
+					if (const char* p = find(delim)) {
+						_buf.append(_in.data, p - _in.data);
+						consume(p - _in.data + 1);
+						return slice(_buf);
+					}
+					_buf.append(_in.data, _in.size);
+					consume(_in.size);
+				}
+				return slice(_buf);
+			}
+
+			void skip(size_t n) { take(n); }
+
+			uint32_t take_be32() {
+				const slice s = take(4);
+				const unsigned char* b =
+					reinterpret_cast<const unsigned char*>(s.data);
+				return uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16
+					| uint32_t(b[2]) << 8 | uint32_t(b[3]);
+			}
+
+		private:
+			yielder_t   _yield;
+			slice       _in;
+			bool        _eof;
+			std::string _buf;
+
+			// need more bytes: suspend until the next buffer.
+			bool fill() {
+				if (_eof)
+					return false;
+				_in = _yield();
+				_eof = _in.empty();
+				return not _eof;
+			}
+
+			slice consume(size_t n) {
+				const slice s = _in.sub(0, n);
+				_in = _in.sub(n, _in.size - n);
+				return s;
+			}
+
+			slice consume_through(const char* p) {
+				const slice s = consume(p - _in.data);
+				consume(1);
+				return s;
+			}
+
+			const char* find(char delim) const {
+				return static_cast<const char*>(
+						std::memchr(_in.data, delim, _in.size));
+			}
+	};
+
+	namespace details {
+
+		template <typename F>
+			struct parser_body {
+				F _f;
+
+				void operator()(reader::yielder_t yield, slice first) {
+					reader in(yield, first);
+					_f(in);
+				}
+			};
+
+	} // namespace details
+
+	// a coroutine<void (slice)> running f(reader&). Once f returned, feeding
+	// it throws.
+	template <typename... CONFIGS, typename F>
+		auto make_parser(F f) -> typename builder<void (slice),
+				details::parser_body<F>, CONFIGS...>::type
+		{
+			return typename builder<void (slice),
+				   details::parser_body<F>, CONFIGS...>::type(
+						   details::parser_body<F>{f});
+		}
+
+	namespace decoder {
+
+		template <typename F>
+			struct length_prefixed_t {
+				F on_message;
+
+				void operator()(reader& in) {
+					while (in.more())
+						on_message(in.take(in.take_be32()));
+				}
+			};
+
+		template <typename F>
+			struct lines_t {
+				F on_line;
+
+				void operator()(reader& in) {
+					while (in.more()) {
+						slice line = in.take_until('\n');
+						if (line.size and line[line.size - 1] == '\r')
+							--line.size;
+						on_line(line);
+					}
+				}
+			};
+
+		// 32 bits big endian length, then the message.
+		template <typename F>
+			length_prefixed_t<F> length_prefixed(F on_message) {
+				return length_prefixed_t<F>{on_message};
+			}
+
+		// '\n' (or "\r\n") terminated lines, the last one may be not.
+		template <typename F>
+			lines_t<F> lines(F on_line) {
+				return lines_t<F>{on_line};
+			}
+
+	} // namespace decoder
+
+} // namespace coroutine
+
+#endif /* PARSER_H */
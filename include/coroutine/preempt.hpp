@@ -0,0 +1,109 @@
+/*
+ * preempt.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef PREEMPT_H
+#define PREEMPT_H
+
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <stdexcept>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * Time slices, for the scheduler.
+ *
+ * Before resuming a task with a time slice, the scheduler arms a one shot
+ * timer (timer_create, one per thread, delivered to this very thread).
+ * When it fires, the signal handler only raises a thread local flag: the
+ * task is over budget. Nothing is interrupted for real, the task leaves
+ * at its next safe point (scheduler::preemption_point()), which costs a
+ * load and a test as long as the budget is not exhausted.
+ *
+ * The signal is SIGURG by default (ignored by everybody, used by Go for
+ * the same purpose), define CORO_PREEMPT_SIGNAL to change it.
+ */
+
+#ifndef CORO_PREEMPT_SIGNAL
+#	define CORO_PREEMPT_SIGNAL SIGURG
+#endif
+
+#ifndef sigev_notify_thread_id
+#	define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace coroutine {
+	namespace details {
+
+		class preempt_timer {
+			public:
+				// the task running on this thread used its whole slice.
+				static bool over_budget() { return flag(); }
+				static void clear() { flag() = 0; }
+
+				static void arm(std::chrono::microseconds slice) {
+					flag() = 0;
+					itimerspec its = {};
+					its.it_value.tv_sec = slice.count() / 1000000;
+					its.it_value.tv_nsec = slice.count() % 1000000 * 1000;
+					::timer_settime(instance()._timer, 0, &its, nullptr);
+				}
+
+				// a signal already on its way may still land after this, so
+				// the flag is cleared again before the next task runs.
+				static void disarm() {
+					const itimerspec its = {};
+					::timer_settime(instance()._timer, 0, &its, nullptr);
+					flag() = 0;
+				}
+
+			private:
+				timer_t _timer;
+
+				preempt_timer() {
+					install_handler();
+					sigevent ev = {};
+					ev.sigev_notify = SIGEV_THREAD_ID;
+					ev.sigev_signo = CORO_PREEMPT_SIGNAL;
+					ev.sigev_notify_thread_id = ::syscall(SYS_gettid);
+					if (::timer_create(CLOCK_MONOTONIC, &ev, &_timer) != 0)
+						throw std::runtime_error("timer_create: preemption");
+				}
+
+				~preempt_timer() { ::timer_delete(_timer); }
+
+				static preempt_timer& instance() {
+					static thread_local preempt_timer t;
+					return t;
+				}
+
+				static volatile sig_atomic_t& flag() {
+					static thread_local volatile sig_atomic_t f = 0;
+					return f;
+				}
+
+				static void on_signal(int) { flag() = 1; }
+
+				static void install_handler() {
+					static const bool installed = [] {
+						struct sigaction sa = {};
+						sa.sa_handler = &on_signal;
+						sa.sa_flags = SA_RESTART;
+						sigemptyset(&sa.sa_mask);
+						return ::sigaction(CORO_PREEMPT_SIGNAL, &sa, nullptr) == 0;
+					}();
+					if (not installed)
+						throw std::runtime_error("sigaction: preemption");
+				}
+		};
+
+	} // namespace details
+} // namespace coroutine
+
+#endif /* PREEMPT_H */
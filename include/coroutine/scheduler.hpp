@@ -0,0 +1,332 @@
+/*
+ * scheduler.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <coroutine/builder.hpp>
+#include <coroutine/preempt.hpp>
+
+namespace coroutine {
+
+	class scheduler;
+
+	// a task is a coroutine owned by a scheduler. It is only ever resumed by
+	// the loop of its scheduler, so its state does not need any
+	// synchronisation. Other threads can only ask for it to be woken up.
+	class task {
+		friend class scheduler;
+
+		public:
+			enum state_t { READY, RUNNING, PARKED };
+
+			virtual ~task() {}
+
+			scheduler& owner() const { return *_owner; }
+			state_t state() const { return _state; }
+
+			// how long the task can run before being asked to leave at its
+			// next scheduler::preemption_point(). 0 means forever. Only
+			// change it from the thread running the scheduler.
+			std::chrono::microseconds time_slice() const { return _slice; }
+			void time_slice(std::chrono::microseconds slice) {
+				_slice = slice;
+			}
+
+			// how many times the task was preempted so far.
+			size_t preemptions() const { return _preemptions; }
+
+		protected:
+			task(scheduler* owner):
+				_owner(owner), _state(READY), _yield(nullptr),
+				_slice(0), _preemptions(0),
+				_prev(nullptr), _next(nullptr) {}
+
+			task(const task&) = delete;
+			task& operator=(const task&) = delete;
+
+			virtual void resume() = 0;
+			virtual bool terminated() const = 0;
+			virtual size_t trim_stack(stack::trim_advice advice) = 0;
+
+			scheduler*              _owner;
+			state_t                 _state;
+			const yielder<void ()>* _yield;
+			std::chrono::microseconds _slice;
+			size_t                  _preemptions;
+
+			// every task of a scheduler, whatever its state.
+			task*                   _prev;
+			task*                   _next;
+	};
+
+	namespace details {
+
+		template <typename F, typename... CONFIGS>
+			class task_impl: public task {
+				struct body {
+					task_impl* self;
+
+					void operator()(yielder<void ()> yield) {
+						self->_yield = &yield;
+						self->_f();
+					}
+				};
+
+				typedef typename builder<void (), body, CONFIGS...>::type
+					coroutine_t;
+
+				public:
+					task_impl(scheduler* owner, F f):
+						task(owner), _f(f), _coro(body{this}) {}
+
+				protected:
+					void resume() { _coro(); }
+					bool terminated() const { return not _coro; }
+					size_t trim_stack(stack::trim_advice advice) {
+						return _coro.trim_stack(advice);
+					}
+
+				private:
+					F           _f;
+					coroutine_t _coro;
+			};
+
+	} // namespace details
+
+	// run many coroutines on one thread. Tasks give back control with
+	// yield() (they stay runnable) or park() (they wait for someone to call
+	// wake() on them, from any thread).
+	class scheduler {
+		public:
+			scheduler(): _alive(0), _remote_pending(false),
+				_tasks(nullptr), _trim_period(0), _trim_countdown(0),
+				_trim_advice(stack::trim_dontneed), _slice(0) {}
+
+			~scheduler() {
+				while (_tasks)
+					destroy(_tasks);
+			}
+
+			scheduler(const scheduler&) = delete;
+			scheduler& operator=(const scheduler&) = delete;
+
+			template <typename... CONFIGS, typename F>
+				task& spawn(F f) {
+					task* t = new details::task_impl<F, CONFIGS...>(this, f);
+					t->_slice = _slice;
+					{
+						std::lock_guard<std::mutex> lock(_remote_lock);
+						link(t);
+					}
+					++_alive;
+					wake(*t);
+					return *t;
+				}
+
+			// resume ready tasks until every spawned task terminated. Sleep
+			// while all of them are parked, waiting for a remote wake().
+			void run() {
+				scheduler* const prev = current_ref();
+				current_ref() = this;
+				try {
+					while (_alive) {
+						task* t = next();
+						_current = t;
+						t->_state = task::RUNNING;
+						const bool timed = t->_slice.count() != 0;
+						// nothing left over from a previous task.
+						details::preempt_timer::clear();
+						if (timed)
+							details::preempt_timer::arm(t->_slice);
+						try {
+							t->resume();
+						} catch (...) {
+							if (timed)
+								details::preempt_timer::disarm();
+							_current = nullptr;
+							destroy(t);
+							throw;
+						}
+						if (timed)
+							details::preempt_timer::disarm();
+						_current = nullptr;
+						if (t->terminated()) {
+							destroy(t);
+						} else if (t->_state == task::RUNNING) {
+							t->_state = task::READY;
+							_ready.push_back(t);
+						}
+						if (_trim_period and not --_trim_countdown) {
+							_trim_countdown = _trim_period;
+							trim_stacks();
+						}
+					}
+				} catch (...) {
+					current_ref() = prev;
+					throw;
+				}
+				current_ref() = prev;
+			}
+
+			// put a parked task back into the ready queue of its scheduler.
+			// Can be called from any thread, the task is queued at the
+			// owner side and resumed only once it actually left.
+			void wake(task& t) {
+				if (current_ref() == this) {
+					t._state = task::READY;
+					_ready.push_back(&t);
+					return;
+				}
+				std::lock_guard<std::mutex> lock(_remote_lock);
+				_remote.push_back(&t);
+				_remote_pending.store(true, std::memory_order_release);
+				_remote_cond.notify_one();
+			}
+
+			// opt-in: every n switches, give back to the system the unused
+			// part of the stack of every suspended task (see
+			// coroutine::trim_stack()). 0 disable it, the default.
+			void trim_stacks_every(size_t n,
+					stack::trim_advice advice = stack::trim_dontneed) {
+				_trim_period = _trim_countdown = n;
+				_trim_advice = advice;
+			}
+
+			// trim the stacks of every suspended task right now, return how
+			// many bytes were released. Only call it from the thread running
+			// the scheduler, or when it is not running.
+			size_t trim_stacks() {
+				size_t bytes = 0;
+				std::lock_guard<std::mutex> lock(_remote_lock);
+				for (task* t = _tasks; t; t = t->_next)
+					if (t != _current)
+						bytes += t->trim_stack(_trim_advice);
+				return bytes;
+			}
+
+			// opt-in preemption: the time slice of the tasks spawned from now
+			// on (see task::time_slice()). 0 disable it, the default.
+			void time_slice(std::chrono::microseconds slice) {
+				_slice = slice;
+			}
+
+			// scheduler running on the calling thread, if any.
+			static scheduler* current() { return current_ref(); }
+
+			// task running on the calling thread, if any.
+			static task* current_task() {
+				scheduler* s = current_ref();
+				return s ? s->_current : nullptr;
+			}
+
+			// same as current_task(), but throw outside of a task.
+			static task& running() {
+				task* t = current_task();
+				if (not t)
+					throw std::runtime_error("not inside a scheduled task");
+				return *t;
+			}
+
+			// give back control to the scheduler, stay runnable.
+			static void yield() {
+				(*running()._yield)();
+			}
+
+			// give back control to the scheduler, until somebody wake() us.
+			static void park() {
+				task& t = running();
+				t._state = task::PARKED;
+				(*t._yield)();
+			}
+
+			// a safe point where the running task leaves if it used its
+			// whole time slice. Cheap enough for the inner loops.
+			static void preemption_point() {
+				if (not details::preempt_timer::over_budget())
+					return;
+				details::preempt_timer::clear();
+				// only a task with a time slice is ever preempted.
+				task* t = current_task();
+				if (t and t->_slice.count()) {
+					++t->_preemptions;
+					(*t->_yield)();
+				}
+			}
+
+		private:
+			std::deque<task*>       _ready;
+			std::deque<task*>       _remote;
+			std::mutex              _remote_lock;
+			std::condition_variable _remote_cond;
+			std::atomic<size_t>     _alive;
+			std::atomic<bool>       _remote_pending;
+			task*                   _current = nullptr;
+			task*                   _tasks;
+			size_t                  _trim_period;
+			size_t                  _trim_countdown;
+			stack::trim_advice      _trim_advice;
+			std::chrono::microseconds _slice;
+
+			void link(task* t) {
+				t->_next = _tasks;
+				if (_tasks)
+					_tasks->_prev = t;
+				_tasks = t;
+			}
+
+			void destroy(task* t) {
+				{
+					std::lock_guard<std::mutex> lock(_remote_lock);
+					if (t->_prev)
+						t->_prev->_next = t->_next;
+					else
+						_tasks = t->_next;
+					if (t->_next)
+						t->_next->_prev = t->_prev;
+				}
+				--_alive;
+				delete t;
+			}
+
+			static scheduler*& current_ref() {
+				static thread_local scheduler* s = nullptr;
+				return s;
+			}
+
+			// the remote queue is only locked when something was pushed in it
+			// or when there is nothing else to do, so a local switch costs
+			// no more than an atomic load.
+			task* next() {
+				if (_ready.empty()
+						or _remote_pending.load(std::memory_order_acquire)) {
+					std::unique_lock<std::mutex> lock(_remote_lock);
+					if (_ready.empty())
+						_remote_cond.wait(lock, [this] {
+								return not _remote.empty(); });
+					for (task* t: _remote) {
+						t->_state = task::READY;
+						_ready.push_back(t);
+					}
+					_remote.clear();
+					_remote_pending.store(false, std::memory_order_relaxed);
+				}
+				task* t = _ready.front();
+				_ready.pop_front();
+				return t;
+			}
+	};
+
+} // namespace coroutine
+
+#endif /* SCHEDULER_H */
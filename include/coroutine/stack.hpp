@@ -44,6 +44,11 @@ namespace coroutine {
 				static const size_t value = V * 1024 * 1024;
 			};
 
+		// how the unused part of a suspended stack is given back to the
+		// system: right now (trim_dontneed), or lazily under memory pressure
+		// (trim_free, falls back to trim_dontneed on older kernels).
+		enum trim_advice { trim_dontneed, trim_free };
+
 		template <typename T>
 			struct is_size {
 				static const bool value
@@ -0,0 +1,196 @@
+/*
+ * stackless.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef STACKLESS_H
+#define STACKLESS_H
+
+#include <stdexcept>
+#include <coroutine/coroutine.hpp>
+
+/*
+ * A stackless coroutine is a simple resumable function: it is called again
+ * on every resume and jumps back right after the last CORO_YIELD (yes, this
+ * is Duff's device). No stack, no context switch, but local variables do not
+ * survive a yield: keep the state in the functor itself (members or mutable
+ * captures).
+ *
+ *   coro<int (), kind::stackless>(
+ *       [=](stackless_yielder<int ()> yield) mutable -> int {
+ *           CORO_REENTER(yield) {
+ *               for (i = 0; i < n; ++i)
+ *                   CORO_YIELD(yield, i);
+ *           }
+ *           return n;
+ *       });
+ *
+ * A stackless_yielder cannot be called: yield(v) does not compile, only
+ * CORO_YIELD can suspend. Do not put a CORO_YIELD inside a switch of your
+ * own.
+ *
+ * Unlike a stackful body, which takes a yielder<RV ()>, a stackless body
+ * takes a stackless_yielder<RV ()>. A call cannot suspend a function without
+ * a stack of its own, so a plain yielder could only fail at run time; the
+ * distinct type turns that mistake into a compile error.
+ */
+
+namespace coroutine {
+
+	namespace kind {
+
+		struct kind_tag {};
+
+		struct stackful: kind_tag {};
+		struct stackless: kind_tag {};
+
+		template <typename T>
+			struct is {
+				static const bool value
+					= details::is_base_of<kind_tag, T>::value;
+			};
+
+		template <typename KIND, typename S, typename F, typename CONTEXT>
+			struct select;
+
+		// the yielder handed to the functor.
+		template <typename KIND, typename S>
+			struct select_yielder {
+				typedef yielder<S> type;
+			};
+
+	} // namespace kind
+
+	namespace details {
+
+		struct resume_point {
+			int  line;
+			bool suspended;
+
+			resume_point& operator=(int l) {
+				line = l;
+				suspended = true;
+				return *this;
+			}
+
+			operator int() const { return line; }
+		};
+
+		struct yielder_access {
+			template <typename RV, typename FV>
+				static resume_point& get_resume_point(
+						const yielder_base<RV, FV>& y) {
+					return *static_cast<resume_point*>(y._coro_ptr);
+				}
+		};
+
+	} // namespace details
+
+	template <typename S>
+		class stackless_yielder;
+
+	// only good for CORO_REENTER and CORO_YIELD.
+	template <typename RV>
+		class stackless_yielder<RV ()>: public yielder_base<RV, void> {
+			typedef yielder_base<RV, void> base_t;
+
+			public:
+			explicit stackless_yielder(details::resume_point* resume):
+				base_t(nullptr, resume) {}
+		};
+
+	template <typename S, typename F>
+		class stackless_coroutine;
+
+	// RV f()
+	template <typename RV, typename F>
+		class stackless_coroutine<RV (), F> {
+			typedef F func_t;
+
+		public:
+			enum state_t { INITIALIZED, RUNNING, TERMINATED };
+
+			stackless_coroutine(func_t f):
+				_resume{0, false},
+				_func(std::move(f)),
+				_state(INITIALIZED)
+			{}
+
+			// no stack, so even a running one can move freely.
+			stackless_coroutine(stackless_coroutine&& from):
+				_resume(from._resume),
+				_func(std::move(from._func)),
+				_state(from._state),
+				_fls(std::move(from._fls))
+			{}
+
+			stackless_coroutine& operator=(
+					const stackless_coroutine& from) = delete;
+
+			RV operator ()()
+			{
+				if (_state == TERMINATED)
+					throw std::runtime_error("terminated coroutine");
+				_state = RUNNING;
+				_resume.suspended = false;
+				details::fls* const prev_fls = details::fls::swap_current(&_fls);
+				try {
+					RV value = _func(stackless_yielder<RV ()>(&_resume));
+					details::fls::restore_current(prev_fls);
+					if (not _resume.suspended)
+						_state = TERMINATED;
+					return value;
+				} catch (...) {
+					details::fls::restore_current(prev_fls);
+					_state = TERMINATED;
+					throw;
+				}
+			}
+
+			operator bool() const {
+				return _state != TERMINATED;
+			}
+
+		private:
+			details::resume_point _resume;
+			func_t                _func;
+			state_t               _state;
+			details::fls          _fls;
+		};
+
+	namespace kind {
+
+		template <typename S, typename F, typename CONTEXT>
+			struct select<stackful, S, F, CONTEXT> {
+				typedef coroutine<S, F, CONTEXT> type;
+			};
+
+		template <typename S, typename F, typename CONTEXT>
+			struct select<stackless, S, F, CONTEXT> {
+				typedef stackless_coroutine<S, F> type;
+			};
+
+		template <typename S>
+			struct select_yielder<stackless, S> {
+				typedef stackless_yielder<S> type;
+			};
+
+	} // namespace kind
+
+} // namespace coroutine
+
+#define CORO_REENTER(yield) \
+	switch (::coroutine::details::yielder_access::get_resume_point(yield)) \
+		case 0:
+
+#define CORO_YIELD(yield, ...) \
+	do { \
+		::coroutine::details::yielder_access::get_resume_point(yield) \
+			= __LINE__; \
+		return (__VA_ARGS__); \
+		case __LINE__:; \
+	} while (0)
+
+#endif /* STACKLESS_H */
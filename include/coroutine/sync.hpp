@@ -0,0 +1,161 @@
+/*
+ * sync.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <deque>
+#include <mutex>
+#include <coroutine/scheduler.hpp>
+
+/*
+ * Synchronisation primitives for tasks running on a scheduler. A waiting
+ * task is queued and parked, so only this task is suspended, not the whole
+ * thread running it. Waiters are woken up through their own scheduler, which
+ * can live on another thread.
+ *
+ * The internal std::mutex only protects the waiter queue for a few
+ * instructions, it is never held across a switch.
+ */
+
+namespace coroutine {
+
+	namespace details {
+
+		inline void wake_one(std::deque<task*>& waiters) {
+			task* t = waiters.front();
+			waiters.pop_front();
+			t->owner().wake(*t);
+		}
+
+	} // namespace details
+
+	// compatible with std::lock_guard and std::unique_lock.
+	class mutex {
+		public:
+			mutex(): _locked(false) {}
+
+			mutex(const mutex&) = delete;
+			mutex& operator=(const mutex&) = delete;
+
+			void lock() {
+				std::unique_lock<std::mutex> guard(_guard);
+				if (not _locked) {
+					_locked = true;
+					return;
+				}
+				_waiters.push_back(&scheduler::running());
+				guard.unlock();
+				// the ownership is handed over by unlock().
+				scheduler::park();
+			}
+
+			bool try_lock() {
+				std::lock_guard<std::mutex> guard(_guard);
+				if (_locked)
+					return false;
+				_locked = true;
+				return true;
+			}
+
+			void unlock() {
+				std::unique_lock<std::mutex> guard(_guard);
+				if (_waiters.empty()) {
+					_locked = false;
+					return;
+				}
+				details::wake_one(_waiters);
+			}
+
+		private:
+			std::mutex        _guard;
+			bool              _locked;
+			std::deque<task*> _waiters;
+	};
+
+	class condition_variable {
+		public:
+			condition_variable() {}
+
+			condition_variable(const condition_variable&) = delete;
+			condition_variable& operator=(const condition_variable&) = delete;
+
+			void wait(std::unique_lock<mutex>& lock) {
+				std::unique_lock<std::mutex> guard(_guard);
+				_waiters.push_back(&scheduler::running());
+				guard.unlock();
+				lock.unlock();
+				scheduler::park();
+				lock.lock();
+			}
+
+			template <typename P>
+				void wait(std::unique_lock<mutex>& lock, P pred) {
+					while (not pred())
+						wait(lock);
+				}
+
+			void notify_one() {
+				std::lock_guard<std::mutex> guard(_guard);
+				if (not _waiters.empty())
+					details::wake_one(_waiters);
+			}
+
+			void notify_all() {
+				std::lock_guard<std::mutex> guard(_guard);
+				while (not _waiters.empty())
+					details::wake_one(_waiters);
+			}
+
+		private:
+			std::mutex        _guard;
+			std::deque<task*> _waiters;
+	};
+
+	class semaphore {
+		public:
+			explicit semaphore(size_t count = 0): _count(count) {}
+
+			semaphore(const semaphore&) = delete;
+			semaphore& operator=(const semaphore&) = delete;
+
+			void acquire() {
+				std::unique_lock<std::mutex> guard(_guard);
+				if (_count) {
+					--_count;
+					return;
+				}
+				_waiters.push_back(&scheduler::running());
+				guard.unlock();
+				// the unit is handed over by release().
+				scheduler::park();
+			}
+
+			bool try_acquire() {
+				std::lock_guard<std::mutex> guard(_guard);
+				if (not _count)
+					return false;
+				--_count;
+				return true;
+			}
+
+			void release(size_t n = 1) {
+				std::lock_guard<std::mutex> guard(_guard);
+				for (; n and not _waiters.empty(); --n)
+					details::wake_one(_waiters);
+				_count += n;
+			}
+
+		private:
+			std::mutex        _guard;
+			size_t            _count;
+			std::deque<task*> _waiters;
+	};
+
+} // namespace coroutine
+
+#endif /* SYNC_H */
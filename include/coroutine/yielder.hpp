@@ -9,6 +9,8 @@
 #define YIELDER_H
 
 #include <iostream>
+#include <stdexcept>
+#include <coroutine/delegate.hpp>
 
 /*
  * TODO
@@ -44,11 +46,18 @@ namespace coroutine {
 		template <typename FV>
 			struct coro_yield_cb_type<void, FV> { typedef FV (*type)(void*); };
 
+		// let the coroutine implementations (and only them) peek inside a
+		// yielder.
+		struct yielder_access;
+
 	} // namespace details
 
 	template <typename S, typename F, typename CONTEXT>
 		class coroutine;
 
+	template <typename S, typename IMPL>
+		class coroutine_base;
+
 	template <typename RV, typename FV>
 		class yielder_base
 		{
@@ -62,6 +71,8 @@ namespace coroutine {
 				}
 
 		protected:
+			friend struct details::yielder_access;
+
 			coro_yield_cb_t _coro_yield_cb;
 			void*           _coro_ptr;
 
@@ -97,13 +108,29 @@ namespace coroutine {
 		{
 			typedef yielder_base<RV, void> base_t;
 			typedef typename base_t::coro_yield_cb_t coro_yield_cb_t;
+			typedef void (*coro_delegate_cb_t)(void*,
+					const details::delegate<RV>&);
 
 			public:
 			void operator()(RV value) const {
 				this->_coro_yield_cb(this->_coro_ptr, value);
 			}
 
-			yielder(coro_yield_cb_t cb, void* coro_ptr): base_t(cb, coro_ptr) {}
+			// yield every value of g (including its final one), as if they
+			// were yielded from here. Return once g terminated.
+			template <typename IMPL>
+				void from(coroutine_base<RV (), IMPL>& g) const {
+					if (not _coro_delegate_cb)
+						throw std::logic_error("this coroutine cannot delegate");
+					_coro_delegate_cb(this->_coro_ptr, g.as_delegate());
+				}
+
+			yielder(coro_yield_cb_t cb, void* coro_ptr,
+					coro_delegate_cb_t dcb = nullptr):
+				base_t(cb, coro_ptr), _coro_delegate_cb(dcb) {}
+
+			private:
+			coro_delegate_cb_t _coro_delegate_cb;
 		};
 
 	// void f(FV feedValue)
@@ -308,18 +308,21 @@ DEFINE_UNARY_POST_OPERATOR(operator --, ops::postdec)
 // A value_expression<V> should aways be instantiated trough make_expression().
 // In the deducted type context of make_expression(),
 // V == rvalue, and V& == lvalue.
+// The rvalue is kept by value: a reference to it would dangle as soon as
+// the expression outlives the full-expression building it (stored in a
+// filter, a range-for...).
 template <typename V>
 struct value_expression: expression<value_expression<V>> {
-	V&& _v;
+	V _v;
 
-	value_expression(const value_expression& from): _v(std::move(from._v)) {}
-	value_expression(value_expression&& from): _v(std::move(from._v)) {}
+	value_expression(const value_expression& from) = default;
+	value_expression(value_expression&& from) = default;
 
 	value_expression(V&& v): _v(std::move(v)) {}
 
 	template <typename E, typename... ARGS>
-	V&& _eval(const E&, ARGS&&...) const {
-		return std::move(_v);
+	const V& _eval(const E&, ARGS&&...) const {
+		return _v;
 	}
 
 	template <int I>
@@ -0,0 +1,161 @@
+/*
+ * mmap.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef MMAP_H
+#define MMAP_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "range.hpp"
+
+/*
+ * Files as ranges, trough mmap: the elements are read straight from the
+ * page cache, nothing is copied, and a range composes with map, filter,
+ * zip, reduce... like any other.
+ *
+ *   long long total = sum(mmap_range<int>("samples.bin"));
+ *   for (auto line: lines("log.txt")) { ... }
+ *
+ * The mapping lives as long as one of the ranges (or their copies) does.
+ * It is read only, and the kernel is told how it will be read: by default
+ * sequentially, so it reads ahead aggressively and drops the pages behind.
+ * Pass MADV_RANDOM (or MADV_NORMAL) for another pattern. Huge pages are
+ * asked for too, where the kernel supports them for files.
+ */
+
+class MappedFile {
+	public:
+		MappedFile(const std::string& path, int advice): _data(empty()),
+			_size(0) {
+			const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				fail("open", path);
+			struct stat st;
+			if (::fstat(fd, &st) != 0) {
+				const int e = errno;
+				::close(fd);
+				errno = e;
+				fail("fstat", path);
+			}
+			_size = st.st_size;
+			// mmap() refuses an empty mapping.
+			if (_size) {
+				void* p = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+				if (p == MAP_FAILED) {
+					const int e = errno;
+					::close(fd);
+					errno = e;
+					fail("mmap", path);
+				}
+				_data = static_cast<const char*>(p);
+				advise(advice);
+			}
+			// the mapping keeps the file.
+			::close(fd);
+		}
+
+		~MappedFile() {
+			if (_size)
+				::munmap(const_cast<char*>(_data), _size);
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const char* data() const { return _data; }
+		size_t size() const { return _size; }
+
+	private:
+		const char* _data;
+		size_t      _size;
+
+		// never null, ArrayRange has to point somewhere even when empty.
+		static const char* empty() {
+			static const std::max_align_t none = {};
+			return reinterpret_cast<const char*>(&none);
+		}
+
+		// only hints, failing is fine.
+		void advise(int advice) {
+			void* p = const_cast<char*>(_data);
+			::madvise(p, _size, advice);
+			if (advice == MADV_SEQUENTIAL)
+				::madvise(p, _size, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+			::madvise(p, _size, MADV_HUGEPAGE);
+#endif
+		}
+
+		static void fail(const char* what, const std::string& path) {
+			throw std::runtime_error(std::string(what) + ": " + path + ": "
+					+ std::strerror(errno));
+		}
+};
+
+// the file as an array of T, a trailing incomplete T is left out.
+template <typename T>
+struct MmapRange: public ArrayRange<const T> {
+	MmapRange(std::shared_ptr<const MappedFile> f):
+		ArrayRange<const T>(reinterpret_cast<const T*>(f->data()),
+				f->size() / sizeof (T)), _file(std::move(f)) {}
+
+	std::shared_ptr<const MappedFile> _file;
+};
+
+template <typename T>
+MmapRange<T> mmap_range(const std::string& path,
+		int advice = MADV_SEQUENTIAL) {
+	return std::make_shared<const MappedFile>(path, advice);
+}
+
+// the lines of the file, without their '\n' (or "\r\n"). The last one may
+// be not terminated. The spans point in the mapping.
+struct LineRange {
+	LineRange(std::shared_ptr<const MappedFile> f): _file(std::move(f)),
+		_p(_file->data()), _e(_file->data() + _file->size()) {
+		next();
+	}
+
+	bool empty() const { return _cur.data == nullptr; }
+	Span<const char> front() const { return _cur; }
+	void pop_front() { next(); }
+
+	std::shared_ptr<const MappedFile> _file;
+	const char*                       _p;
+	const char*                       _e;
+	Span<const char>                  _cur;
+
+	void next() {
+		if (_p == _e) {
+			_cur = Span<const char>{nullptr, 0};
+			return;
+		}
+		const char* nl = static_cast<const char*>(
+				std::memchr(_p, '\n', _e - _p));
+		const char* end = nl ? nl : _e;
+		_cur = Span<const char>{_p, size_t(end - _p)};
+		if (_cur.size and end[-1] == '\r')
+			--_cur.size;
+		_p = nl ? nl + 1 : _e;
+	}
+};
+
+inline LineRange lines(const std::string& path,
+		int advice = MADV_SEQUENTIAL) {
+	return std::make_shared<const MappedFile>(path, advice);
+}
+
+#endif /* MMAP_H */
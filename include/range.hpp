@@ -8,56 +8,86 @@
 #ifndef RANGE_H
 #define RANGE_H
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
 
 #include "tools.hpp"
 #include "tuple.hpp"
 
-// a simple number range
+// a simple number range. The elements are computed as begin + i * step, so
+// there is no error accumulated along the way, and any of them is O(1).
 template <typename T>
 struct NumberRange {
-	constexpr NumberRange(T begin, T end, T step): _b(begin), _e(end),
-		_s(begin <= end or step < 0 ? step : -step) {}
+	constexpr NumberRange(T begin, T end, T step): _b(begin),
+		_s(begin <= end or step < 0 ? step : -step), _i(0),
+		_n(count(begin, end, begin <= end or step < 0 ? step : -step)) {}
 	constexpr NumberRange(NumberRange&& r) = default;
 	NumberRange(const NumberRange&) = default;
 
 	NumberRange& operator=(NumberRange from) = delete;
 	NumberRange& operator=(NumberRange&& from) = delete;
 
-	bool empty() const {
-		if (_s > 0)
-			return _b >= _e;
-		return _b <= _e;
-	}
+	constexpr bool empty() const { return _i >= _n; }
 
-	void pop_front() { _b += _s; }
-	T front() const { return _b; }
+	void pop_front() { ++_i; }
+	void drop_front(size_t n) { _i += n; }
+	constexpr T front() const { return _b + T(_i) * _s; }
 
-	void pop_back() { _e += _s; }
-	T back() const { return _e; }
+	void pop_back() { --_n; }
+	void drop_back(size_t n) { _n -= n; }
+	constexpr T back() const { return _b + T(_n - 1) * _s; }
 
-	size_t size() const {
-		const T fract_size = (_e - _b) / _s;
-		return (fract_size - size_t(fract_size)) > 0 ?
-			 fract_size + 1 : fract_size;
-	};
+	constexpr size_t size() const { return _n - _i; }
 
-	T operator[](size_t idx) {
-		const T v = _b + idx * _s;
-		if ((_s > 0) ? (v >= _e) : (v <= _e)) {
-			throw std::overflow_error("out of bound");
-		}
-		return v;
+	// unchecked, like ArrayRange: a bound check stops the compiler from
+	// turning a loop over the range into a closed form.
+	constexpr T operator[](size_t idx) const {
+		return _b + T(_i + idx) * _s;
 	}
 
-	T _b, _e;
+	// closed form: n * front + step * n(n - 1) / 2.
+	constexpr T sum() const {
+		return T(size()) * front() + _s * T(triangle(size()));
+	}
+
+	T const _b;
 	T const _s;
+	size_t _i, _n;
+
+	// how many steps from begin to end, the last one can be incomplete.
+	static constexpr size_t count(T begin, T end, T step) {
+		return step > 0 ?
+			(begin < end ? round_up(size_t((end - begin) / step), end - begin, step) : 0)
+			: (begin > end ? round_up(size_t((begin - end) / -step), begin - end, -step) : 0);
+	}
+
+	// n(n - 1) / 2, halving the even factor first: n(n - 1) alone would
+	// overflow long before the result does.
+	static constexpr size_t triangle(size_t n) {
+		return n % 2 ? n * ((n - 1) / 2) : n / 2 * (n - 1);
+	}
+
+	// an integer division truncates, so check the remainder by hand.
+	static constexpr size_t round_up(size_t n, T span, T step) {
+		return T(n) * step < span ? n + 1 : n;
+	}
 };
 
 template <typename S = int, typename B, typename E>
 constexpr auto range(B begin, E end, S step = 1)
 	-> NumberRange<decltype(begin + end + step)> {
-	return {begin, end, step};
+	typedef decltype(begin + end + step) T;
+	return {T(begin), T(end), T(step)};
 }
 
 template <typename E>
@@ -66,21 +96,52 @@ constexpr auto range(E end)
 	return range(0, end);
 }
 
+// a pointer and a length, handed out by next_block().
+template <typename T>
+struct Span {
+	T*     data;
+	size_t size;
+
+	bool empty() const { return size == 0; }
+	T& operator[](size_t idx) const { return data[idx]; }
+	T* begin() const { return data; }
+	T* end() const { return data + size; }
+};
+
 // make a range referencing a little C style array.
 template <typename T>
 struct ArrayRange {
 	ArrayRange(T* a, T* e): _b(a), _e(e) {}
-	ArrayRange(T* a, size_t s): _b(a), _e(a + s - 1) {}
+	// empty: _e just before _b, without going below a (a null pointer,
+	// from an empty vector, would wrap around).
+	ArrayRange(T* a, size_t s): _b(s ? a : a + 1), _e(s ? a + s - 1 : a) {}
 
 	bool empty() const { return _b > _e; }
 	void pop_front() { ++_b; }
+	void drop_front(size_t n) { _b += n; }
 	T& front() const { return *_b; }
 	void pop_back() { --_e; }
+	void drop_back(size_t n) { _e -= n; }
 	T& back() const { return *_e; }
 
 	T& operator[](size_t idx) { return _b[idx]; }
 
-	size_t size() const { return _e - _b; };
+	size_t size() const { return _e - _b + 1; };
+
+	// contiguous: consume up to max elements at once.
+	Span<T> next_block(size_t max = size_t(-1)) {
+		const size_t n = empty() ? 0 : std::min(max, size());
+		const Span<T> s = {_b, n};
+		_b += n;
+		return s;
+	}
+
+	// the block protocol: where the blocks come from, and visit(x, k)
+	// calls k with what an element of a block becomes, if it is part of the
+	// range at all.
+	ArrayRange& block_source() { return *this; }
+	template <typename K>
+	void visit(T& x, K& k) const { k(x); }
 
 	T* _b;
 	T* _e;
@@ -96,6 +157,11 @@ template <typename R>
 struct Constifier: public R {
 	Constifier(R r): R(r) {}
 
+	// R's spans and blocks would hand out mutable elements.
+	template <typename... A> void next_block(A&&...) = delete;
+	template <typename... A> void block_source(A&&...) = delete;
+	template <typename... A> void visit(A&&...) = delete;
+
 	typename constit<typename range_info<R>::type>::type front() {
 		return R::front();
 	}
@@ -115,6 +181,11 @@ template <typename R>
 struct Reverser: public R {
 	Reverser(R r): R(r) {}
 
+	// R's spans and blocks would be in the wrong order.
+	template <typename... A> void next_block(A&&...) = delete;
+	template <typename... A> void block_source(A&&...) = delete;
+	template <typename... A> void visit(A&&...) = delete;
+
 	void pop_front() { R::pop_back(); }
 	auto front() -> typename range_info<R>::type {
 		return R::back();
@@ -126,6 +197,16 @@ struct Reverser: public R {
 	auto operator[](size_t idx) -> typename range_info<R>::type {
 		return R::operator[](R::size() - 1 - idx);
 	}
+
+	// hides R::drop_front(), which would drop from the wrong end.
+	template <typename U = R>
+	auto drop_front(size_t n) -> decltype(std::declval<U&>().drop_back(n)) {
+		R::drop_back(n);
+	}
+	template <typename U = R>
+	auto drop_back(size_t n) -> decltype(std::declval<U&>().drop_front(n)) {
+		R::drop_front(n);
+	}
 };
 
 template <typename R>
@@ -139,6 +220,11 @@ struct Enumerator: public R {
 
 	Enumerator(R r, size_t start): R(r), _idx(start) {}
 
+	// R's spans and blocks would have no indices.
+	template <typename... A> void next_block(A&&...) = delete;
+	template <typename... A> void block_source(A&&...) = delete;
+	template <typename... A> void visit(A&&...) = delete;
+
 	void pop_front() { R::pop_front(); ++_idx; }
 	tuple_t front() {
 		return tuple_t(_idx, R::front());
@@ -149,7 +235,13 @@ struct Enumerator: public R {
 	}
 
 	tuple_t operator[](size_t idx) {
-		return R::operator[](R::size() - 1 - idx);
+		return tuple_t(_idx + idx, R::operator[](idx));
+	}
+
+	template <typename U = R>
+	auto drop_front(size_t n) -> decltype(std::declval<U&>().drop_front(n)) {
+		R::drop_front(n);
+		_idx += n;
 	}
 
 	size_t _idx;
@@ -166,6 +258,7 @@ struct Zipper {
 	tuple<Ranges...> ranges;
 
 	Zipper(Ranges... rs): ranges(rs...) {}
+	explicit Zipper(tuple<Ranges...> rs): ranges(std::move(rs)) {}
 
 	// should be inline instantiated in empty(),
 	// but gcc complain.
@@ -181,10 +274,11 @@ struct Zipper {
 	}
 
 	// should be inline instantiated in front(),
-	// but gcc complain.
+	// but gcc complain. The ranges are taken by reference, nothing is
+	// copied.
 	struct front_map {
 		template <typename T>
-			auto operator()(T range) -> decltype(range.front()) {
+			auto operator()(T& range) -> decltype(range.front()) {
 				return range.front();
 			}
 	};
@@ -214,10 +308,12 @@ Zipper<Ranges...> zip(Ranges... rs) { return Zipper<Ranges...>(rs...); }
 
 template <typename FV, typename... Ranges>
 struct LongZipper {
-	typedef FV const& fillval_t;
 	// because of the C++11 reference collapsing rules, and
 	// the fact that const cannot be applied to a reference:
-	// T& => T&, T&& => const T&, const T& => const T&
+	// T& => T&, const T& => const T&. A temporary (FV is not a reference)
+	// would not outlive the call to longzip(), it is kept by value.
+	typedef typename std::conditional<std::is_reference<FV>::value,
+			FV const&, const FV>::type fillval_t;
 	fillval_t fillval;
 	tuple<Ranges...> ranges;
 
@@ -241,8 +337,28 @@ struct LongZipper {
 
 	typedef tuple<typename range_type<Ranges>::type...> return_type;
 
+	// while every range still has elements, there is no need to check
+	// them one by one: that is the fast phase, _common elements long when
+	// every range is finite. Then comes the fill phase.
+	size_t _common;
+
 	LongZipper(FV&& fillval, Ranges... rs):
-		fillval(std::forward<FV>(fillval)), ranges(rs...) {}
+		fillval(std::forward<FV>(fillval)), ranges(rs...),
+		_common(tuple_reduce(common_reduce(), ranges, size_t(-1))) {}
+
+	// an infinite (or unknown length) range disables the fast phase.
+	struct common_reduce {
+		template <typename T2>
+			typename std::enable_if<is_finite_range<T2>::value, size_t>::type
+			operator()(size_t a, const T2& range) {
+				return std::min(a, range.empty() ? size_t(0) : range.size());
+			}
+		template <typename T2>
+			typename std::enable_if<not is_finite_range<T2>::value, size_t>::type
+			operator()(size_t, const T2&) {
+				return 0;
+			}
+	};
 
 	struct empty_reduce {
 		template <typename T2>
@@ -252,19 +368,31 @@ struct LongZipper {
 	};
 
 	bool empty() const {
-		return tuple_reduce(empty_reduce(), this->ranges, true);
+		return not _common
+			and tuple_reduce(empty_reduce(), this->ranges, true);
 	}
 
 	struct front_map {
 		FV const& fillval;
 		template <typename T>
-			auto operator()(T range)
+			auto operator()(T& range)
 			-> typename range_type<T>::type {
 				return range.empty() ? fillval : range.front();
 			}
 	};
 
+	struct fast_front_map {
+		template <typename T>
+			auto operator()(T& range)
+			-> typename range_type<T>::type {
+				return range.front();
+			}
+	};
+
 	return_type front() {
+		if (_common) {
+			return return_type(tuple_map_tag, fast_front_map(), ranges);
+		}
 		return return_type(tuple_map_tag, front_map{fillval}, ranges);
 	}
 
@@ -277,8 +405,20 @@ struct LongZipper {
 			}
 	};
 
+	struct fast_pop_front_foreach {
+		template <typename T>
+			void operator()(T& range) {
+				range.pop_front();
+			}
+	};
+
 	void pop_front() {
-		tuple_foreach(this->ranges, pop_front_foreach());
+		if (_common) {
+			--_common;
+			tuple_foreach(this->ranges, fast_pop_front_foreach());
+		} else {
+			tuple_foreach(this->ranges, pop_front_foreach());
+		}
 	}
 };
 
@@ -293,6 +433,88 @@ LongZipper<FV, Ranges...> longzip(FV&& fillval, Ranges... rs) {
 }
 
 
+// cut a range in spans of up to n elements, the last one can be shorter.
+template <typename R, bool = is_contiguous_range<R>::value>
+struct Chunker;
+
+// contiguous: the spans point in the source, nothing is copied.
+template <typename R>
+struct Chunker<R, true> {
+	typedef decltype(std::declval<R&>().next_block()) span_t;
+
+	Chunker(size_t n, R r): _n(n), _r(r), _cur(_r.next_block(_n)) {}
+
+	bool empty() const { return _cur.empty(); }
+	span_t front() const { return _cur; }
+	void pop_front() { _cur = _r.next_block(_n); }
+
+	size_t _n;
+	R      _r;
+	span_t _cur;
+};
+
+// otherwise, the elements are copied in a buffer allocated once, and
+// overwritten by the next span. Raw storage, not a std::vector: there is
+// no bool* in a std::vector<bool>, and an element (a tuple of references
+// from enumerate()...) may be neither default constructible nor assignable.
+template <typename R>
+struct Chunker<R, false> {
+	typedef typename std::decay<typename range_info<R>::type>::type value_t;
+	typedef typename std::aligned_storage<sizeof (value_t),
+			alignof (value_t)>::type slot_t;
+
+	Chunker(size_t n, R r): _n(n), _r(r), _buf(new slot_t[n]), _size(0) {
+		fill();
+	}
+
+	Chunker(const Chunker& from): _n(from._n), _r(from._r),
+		_buf(new slot_t[from._n]), _size(0) {
+		for (; _size < from._size; ++_size) {
+			new (&_buf[_size]) value_t(from.data()[_size]);
+		}
+	}
+	Chunker(Chunker&& from): _n(from._n), _r(std::move(from._r)),
+		_buf(std::move(from._buf)), _size(from._size) {
+		from._size = 0;
+	}
+
+	~Chunker() { clear(); }
+
+	bool empty() const { return not _size; }
+	Span<value_t> front() { return {data(), _size}; }
+	void pop_front() { fill(); }
+
+	size_t                    _n;
+	R                         _r;
+	std::unique_ptr<slot_t[]> _buf;
+	size_t                    _size;
+
+	value_t* data() const { return reinterpret_cast<value_t*>(_buf.get()); }
+
+	void clear() {
+		for (size_t i = 0; i < _size; ++i) {
+			data()[i].~value_t();
+		}
+		_size = 0;
+	}
+
+	void fill() {
+		clear();
+		for (; _size < _n and not _r.empty(); _r.pop_front()) {
+			new (&_buf[_size]) value_t(_r.front());
+			++_size;
+		}
+	}
+};
+
+template <typename R>
+Chunker<R> chunk(size_t n, R r) {
+	if (not n) {
+		throw std::range_error("cannot chunk by 0 elements!");
+	}
+	return {n, r};
+}
+
 // map a function to a range
 template <typename F, typename R>
 struct Mapper {
@@ -306,6 +528,39 @@ struct Mapper {
 		return _f(_r.front());
 	}
 
+	// random and finite when R is.
+	template <typename U = R>
+	auto size() const -> decltype(std::declval<const U&>().size()) {
+		return _r.size();
+	}
+	template <typename U = R>
+	auto operator[](size_t idx) -> decltype(
+			std::declval<F&>()(std::declval<U&>()[idx])) {
+		return _f(_r[idx]);
+	}
+	template <typename U = R>
+	auto drop_front(size_t n) -> decltype(std::declval<U&>().drop_front(n)) {
+		_r.drop_front(n);
+	}
+
+	// a block range when R is.
+	template <typename U = R>
+	auto block_source() -> decltype(std::declval<U&>().block_source()) {
+		return _r.block_source();
+	}
+	template <typename K>
+	struct visitor {
+		F& f;
+		K& k;
+		template <typename E>
+		void operator()(E&& e) { k(f(std::forward<E>(e))); }
+	};
+	template <typename X, typename K>
+	void visit(X& x, K& k) {
+		visitor<K> v{_f, k};
+		_r.visit(x, v);
+	}
+
 	F _f;
 	R _r;
 };
@@ -313,4 +568,312 @@ struct Mapper {
 template <typename F, typename R>
 Mapper<F, R> map(F f, R r) { return {f, r}; }
 
+// merge N sorted ranges of the same type into one sorted range.
+// A loser tree over the heads of the ranges gives the smallest in O(1),
+// and only the range it comes from is advanced (and compared again,
+// log2(N) times) by pop_front(). On equal heads, the first range wins.
+template <typename R, typename L = std::less<
+	typename std::decay<typename range_info<R>::type>::type> >
+struct Merger {
+	Merger(std::vector<R> rs, L less = L()):
+		_ranges(std::move(rs)), _tree(_ranges.size()), _less(less) {
+		if (not _ranges.empty())
+			_tree[0] = build(1);
+	}
+
+	bool empty() const {
+		return _ranges.empty() or _ranges[_tree[0]].empty();
+	}
+
+	auto front() -> typename range_info<R>::type {
+		return _ranges[_tree[0]].front();
+	}
+
+	void pop_front() {
+		size_t winner = _tree[0];
+		_ranges[winner].pop_front();
+		// replay the matches of the winner, from its leaf to the root.
+		for (size_t node = (winner + _ranges.size()) / 2; node; node /= 2)
+			if (beats(_tree[node], winner))
+				std::swap(_tree[node], winner);
+		_tree[0] = winner;
+	}
+
+	std::vector<R> _ranges;
+	// _tree[0] is the winner, _tree[1.._ranges.size()) the losers of
+	// every match. Leaf i is the node _ranges.size() + i.
+	std::vector<size_t> _tree;
+	L _less;
+
+	// an empty range loses against anything.
+	bool beats(size_t a, size_t b) {
+		if (_ranges[a].empty())
+			return false;
+		if (_ranges[b].empty())
+			return true;
+		if (_less(_ranges[a].front(), _ranges[b].front()))
+			return true;
+		return a < b and not _less(_ranges[b].front(), _ranges[a].front());
+	}
+
+	size_t build(size_t node) {
+		if (node >= _ranges.size())
+			return node - _ranges.size();
+		const size_t l = build(node * 2);
+		const size_t r = build(node * 2 + 1);
+		if (beats(l, r)) {
+			_tree[node] = r;
+			return l;
+		}
+		_tree[node] = l;
+		return r;
+	}
+};
+
+template <typename R>
+Merger<R> merge(std::vector<R> rs) { return Merger<R>(std::move(rs)); }
+
+template <typename R, typename... Rs>
+Merger<R> merge(R r, Rs... rs) { return Merger<R>({r, rs...}); }
+
+template <typename L, typename R>
+Merger<R, L> merge_by(L less, std::vector<R> rs) {
+	return Merger<R, L>(std::move(rs), less);
+}
+
+// set operations on sorted ranges. Like their std:: counterparts, they
+// take repeated elements into account: an element m times in r1 and n
+// times in r2 comes min(m, n) times out of set_intersection(), max(m, n)
+// times out of set_union() and m - n times out of set_difference().
+//
+// To skip the elements of one range below the front of the other, a range
+// that can drop elements at once (ArrayRange, NumberRange and maps of
+// them) is searched exponentially then by dichotomy: O(log d) to skip d
+// elements, so a small range against a big one costs little. Arrays of
+// int compare 4 elements at once first (SSE2).
+
+// steps of one element on the same side before a set operation starts to
+// search, as timsort does: dense inputs are merged at full speed.
+#ifndef SET_GALLOP_AFTER
+#	define SET_GALLOP_AFTER 4
+#endif
+
+namespace details {
+
+	// the first 16 elements, by blocks of 4. Sorted, so the elements
+	// below x are a prefix of the block. True when done.
+#ifdef __SSE2__
+	// exactly an ArrayRange: an adapter deriving from it (a Reverser...)
+	// does not have its elements at _b.
+	template <typename R>
+	auto block_skip(R& r, int x, std::less<int>&, int)
+		-> typename std::enable_if<std::is_same<R, ArrayRange<int> >::value
+		or std::is_same<R, ArrayRange<const int> >::value, bool>::type {
+		const size_t n = r.size();
+		const __m128i v = _mm_set1_epi32(x);
+		size_t i = 0;
+		for (; i + 4 <= n and i < 16; i += 4) {
+			const __m128i b = _mm_loadu_si128(
+					reinterpret_cast<const __m128i*>(r._b + i));
+			const int below = _mm_movemask_ps(
+					_mm_castsi128_ps(_mm_cmplt_epi32(b, v)));
+			if (below != 0xf) {
+				r.drop_front(i + __builtin_popcount(below));
+				return true;
+			}
+		}
+		r.drop_front(i);
+		return false;
+	}
+#endif
+
+	template <typename R, typename X, typename L>
+	bool block_skip(R&, const X&, L&, long) { return false; }
+
+	// exponentially, then by dichotomy.
+	template <typename R, typename X, typename L>
+	void gallop(R& r, const X& x, L& less) {
+		const size_t n = r.size();
+		if (not n or not less(r[0], x)) {
+			return;
+		}
+		// r[lo] < x, then the first element not below x is in (lo, hi].
+		size_t lo = 0, hi = 1;
+		while (hi < n and less(r[hi], x)) {
+			lo = hi;
+			hi = hi * 2 + 1;
+		}
+		hi = std::min(hi, n);
+		while (hi - lo > 1) {
+			const size_t mid = lo + (hi - lo) / 2;
+			if (less(r[mid], x)) {
+				lo = mid;
+			} else {
+				hi = mid;
+			}
+		}
+		r.drop_front(hi);
+	}
+
+	// drop the elements of r below x. Mostly a short step: one element,
+	// a few blocks, and only then the search.
+	template <typename R, typename X, typename L>
+	auto skip_below(R& r, const X& x, L& less) -> typename std::enable_if<
+		is_droppable_range<R>::value>::type {
+		if (r.empty() or not less(r[0], x)) {
+			return;
+		}
+		if (r.size() == 1 or not less(r[1], x)) {
+			r.drop_front(1);
+			return;
+		}
+		if (not block_skip(r, x, less, 0)) {
+			gallop(r, x, less);
+		}
+	}
+
+	template <typename R, typename X, typename L>
+	auto skip_below(R& r, const X& x, L& less) -> typename std::enable_if<
+		not is_droppable_range<R>::value>::type {
+		while (not r.empty() and less(r.front(), x)) {
+			r.pop_front();
+		}
+	}
+
+} // namespace details
+
+template <typename R1, typename R2, typename L>
+struct Intersecter {
+	Intersecter(R1 r1, R2 r2, L less): _r1(r1), _r2(r2), _less(less) {
+		settle();
+	}
+
+	bool empty() const { return _r1.empty() or _r2.empty(); }
+	auto front() -> typename range_info<R1>::type { return _r1.front(); }
+
+	void pop_front() {
+		_r1.pop_front();
+		_r2.pop_front();
+		settle();
+	}
+
+	R1 _r1;
+	R2 _r2;
+	L  _less;
+
+	// until both fronts are equal.
+	void settle() {
+		size_t run1 = 0, run2 = 0;
+		while (not _r1.empty() and not _r2.empty()) {
+			if (_less(_r1.front(), _r2.front())) {
+				run2 = 0;
+				if (++run1 < SET_GALLOP_AFTER) {
+					_r1.pop_front();
+				} else {
+					details::skip_below(_r1, _r2.front(), _less);
+				}
+			} else if (_less(_r2.front(), _r1.front())) {
+				run1 = 0;
+				if (++run2 < SET_GALLOP_AFTER) {
+					_r2.pop_front();
+				} else {
+					details::skip_below(_r2, _r1.front(), _less);
+				}
+			} else {
+				return;
+			}
+		}
+	}
+};
+
+template <typename R1, typename R2, typename L>
+struct Uniter {
+	typedef typename std::decay<typename range_info<R1>::type>::type value_t;
+
+	Uniter(R1 r1, R2 r2, L less): _r1(r1), _r2(r2), _less(less) {}
+
+	bool empty() const { return _r1.empty() and _r2.empty(); }
+
+	value_t front() {
+		if (_r1.empty() or (not _r2.empty()
+					and _less(_r2.front(), _r1.front()))) {
+			return _r2.front();
+		}
+		return _r1.front();
+	}
+
+	void pop_front() {
+		if (_r1.empty()) {
+			_r2.pop_front();
+		} else if (_r2.empty() or _less(_r1.front(), _r2.front())) {
+			_r1.pop_front();
+		} else if (_less(_r2.front(), _r1.front())) {
+			_r2.pop_front();
+		} else {
+			_r1.pop_front();
+			_r2.pop_front();
+		}
+	}
+
+	R1 _r1;
+	R2 _r2;
+	L  _less;
+};
+
+template <typename R1, typename R2, typename L>
+struct Differ {
+	Differ(R1 r1, R2 r2, L less): _r1(r1), _r2(r2), _less(less) {
+		settle();
+	}
+
+	bool empty() const { return _r1.empty(); }
+	auto front() -> typename range_info<R1>::type { return _r1.front(); }
+
+	void pop_front() {
+		_r1.pop_front();
+		settle();
+	}
+
+	R1 _r1;
+	R2 _r2;
+	L  _less;
+
+	// until the front of r1 is not in r2.
+	void settle() {
+		size_t run = 0;
+		while (not _r1.empty() and not _r2.empty()) {
+			if (_less(_r2.front(), _r1.front())) {
+				if (++run < SET_GALLOP_AFTER) {
+					_r2.pop_front();
+				} else {
+					details::skip_below(_r2, _r1.front(), _less);
+				}
+			} else if (_less(_r1.front(), _r2.front())) {
+				return;
+			} else {
+				_r1.pop_front();
+				_r2.pop_front();
+			}
+		}
+	}
+};
+
+template <typename R1, typename R2, typename L = std::less<
+	typename std::decay<typename range_info<R1>::type>::type> >
+Intersecter<R1, R2, L> set_intersection(R1 r1, R2 r2, L less = L()) {
+	return {r1, r2, less};
+}
+
+template <typename R1, typename R2, typename L = std::less<
+	typename std::decay<typename range_info<R1>::type>::type> >
+Uniter<R1, R2, L> set_union(R1 r1, R2 r2, L less = L()) {
+	return {r1, r2, less};
+}
+
+template <typename R1, typename R2, typename L = std::less<
+	typename std::decay<typename range_info<R1>::type>::type> >
+Differ<R1, R2, L> set_difference(R1 r1, R2 r2, L less = L()) {
+	return {r1, r2, less};
+}
+
 #endif /* RANGE_H */
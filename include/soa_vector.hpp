@@ -0,0 +1,169 @@
+/*
+ * soa_vector.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef SOA_VECTOR_H
+#define SOA_VECTOR_H
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tuple.hpp"
+#include "range.hpp"
+
+/*
+ * A vector of rows stored by columns: every field in its own contiguous
+ * array. A scan over one column reads that column only, instead of
+ * pulling every field of every row trough the cache.
+ *
+ *   soa_vector<int, double> v;
+ *   v.push_back(1, 2.5);
+ *   double total = sum(v.column<1>());
+ *   for (auto row: v.rows()) get<1>(row) *= get<0>(row);
+ *
+ * A row is a tuple<Ts&...> on the columns, rows() is a zip() of the
+ * columns, so it composes with any other range. No bool column: a
+ * std::vector<bool> has no contiguous storage to range over, use an
+ * unsigned char instead.
+ */
+
+namespace details {
+
+	template <typename... Ts>
+	struct soa_columns;
+
+	// push a value on every column, one after the other. If one throws,
+	// the columns already pushed are popped back.
+	template <typename T, typename... Ts>
+	struct soa_columns<T, Ts...> {
+		static const bool has_bool = std::is_same<T, bool>::value
+			or soa_columns<Ts...>::has_bool;
+
+		template <typename U, typename... Us>
+		static void push(tuple<std::vector<T>, std::vector<Ts>...>& cols,
+				U&& v, Us&&... vs) {
+			cols._p_value.push_back(std::forward<U>(v));
+			try {
+				soa_columns<Ts...>::push(
+						static_cast<tuple<std::vector<Ts>...>&>(cols),
+						std::forward<Us>(vs)...);
+			} catch (...) {
+				cols._p_value.pop_back();
+				throw;
+			}
+		}
+	};
+
+	template <>
+	struct soa_columns<> {
+		static const bool has_bool = false;
+		static void push(tuple<>&) {}
+	};
+
+	struct soa_reserve {
+		size_t n;
+		template <typename V>
+		void operator()(V& col) { col.reserve(n); }
+	};
+
+	struct soa_resize {
+		size_t n;
+		template <typename V>
+		void operator()(V& col) { col.resize(n); }
+	};
+
+	struct soa_clear {
+		template <typename V>
+		void operator()(V& col) { col.clear(); }
+	};
+
+	struct soa_pop_back {
+		template <typename V>
+		void operator()(V& col) { col.pop_back(); }
+	};
+
+	struct soa_at {
+		size_t i;
+		template <typename V>
+		auto operator()(V& col) -> decltype(col[i]) { return col[i]; }
+	};
+
+	struct soa_range {
+		template <typename T>
+		ArrayRange<T> operator()(std::vector<T>& col) {
+			return ArrayRange<T>(col.data(), col.size());
+		}
+		template <typename T>
+		ArrayRange<const T> operator()(const std::vector<T>& col) {
+			return ArrayRange<const T>(col.data(), col.size());
+		}
+	};
+
+} // namespace details
+
+template <typename... Ts>
+class soa_vector {
+	static_assert(not details::soa_columns<Ts...>::has_bool,
+			"no bool column, use unsigned char");
+
+	public:
+		typedef tuple<Ts&...> row_t;
+		typedef tuple<const Ts&...> const_row_t;
+
+		size_t size() const { return get_ref<0>(_cols).size(); }
+		bool empty() const { return not size(); }
+
+		void reserve(size_t n) { tuple_foreach(_cols, details::soa_reserve{n}); }
+		void resize(size_t n) { tuple_foreach(_cols, details::soa_resize{n}); }
+		void clear() { tuple_foreach(_cols, details::soa_clear()); }
+		void pop_back() { tuple_foreach(_cols, details::soa_pop_back()); }
+
+		// one value per column, all or none.
+		template <typename... Us>
+		void push_back(Us&&... values) {
+			static_assert(sizeof... (Us) == sizeof... (Ts),
+					"one value per column");
+			details::soa_columns<Ts...>::push(_cols,
+					std::forward<Us>(values)...);
+		}
+
+		row_t operator[](size_t i) {
+			return row_t(tuple_map_tag, details::soa_at{i}, _cols);
+		}
+
+		const_row_t operator[](size_t i) const {
+			return const_row_t(tuple_map_tag, details::soa_at{i}, _cols);
+		}
+
+		// the column I alone, random access and contiguous.
+		template <size_t I>
+		ArrayRange<typename tuple_elem<I, Ts...>::type> column() {
+			return details::soa_range()(get_ref<I>(_cols));
+		}
+
+		template <size_t I>
+		ArrayRange<const typename tuple_elem<I, Ts...>::type> column() const {
+			return details::soa_range()(get_ref<I>(_cols));
+		}
+
+		// every row, as a zip() of the columns.
+		Zipper<ArrayRange<Ts>...> rows() {
+			return Zipper<ArrayRange<Ts>...>(tuple<ArrayRange<Ts>...>(
+						tuple_map_tag, details::soa_range(), _cols));
+		}
+
+		Zipper<ArrayRange<const Ts>...> rows() const {
+			return Zipper<ArrayRange<const Ts>...>(
+					tuple<ArrayRange<const Ts>...>(
+						tuple_map_tag, details::soa_range(), _cols));
+		}
+
+	private:
+		tuple<std::vector<Ts>...> _cols;
+};
+
+#endif /* SOA_VECTOR_H */
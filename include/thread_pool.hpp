@@ -0,0 +1,161 @@
+/*
+ * thread_pool.hpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#pragma once
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of threads running one parallel_for at a time. The calling
+// thread takes part in the work, so a pool of size n has n - 1 threads.
+class thread_pool {
+	public:
+		explicit thread_pool(size_t size):
+			_run(nullptr), _arg(nullptr), _count(0), _next(0), _done(0),
+			_generation(0), _active(0), _stop(false)
+		{
+			for (size_t i = 1; i < size; ++i)
+				_workers.emplace_back([this] { worker(); });
+		}
+
+		~thread_pool() {
+			{
+				std::lock_guard<std::mutex> lock(_lock);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (std::thread& t: _workers)
+				t.join();
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		// one per hardware thread, created on first use.
+		static thread_pool& instance() {
+			static thread_pool pool(std::max(1u,
+						std::thread::hardware_concurrency()));
+			return pool;
+		}
+
+		size_t size() const { return _workers.size() + 1; }
+
+		// f(i) for every i in [0, n), in any order, on any thread. Return
+		// once they are all done, re-throw the first exception if any.
+		// Called from inside a job, it simply runs f sequentially.
+		template <typename F>
+			void parallel_for(size_t n, F f) {
+				if (_workers.empty() or n < 2 or in_job()) {
+					for (size_t i = 0; i < n; ++i)
+						f(i);
+					return;
+				}
+				std::lock_guard<std::mutex> submit(_submit);
+				std::unique_lock<std::mutex> lock(_lock);
+				// late workers of the previous job must be gone.
+				_idle.wait(lock, [this] { return _active == 0; });
+				_run = &call<F>;
+				_arg = &f;
+				_count = n;
+				_next.store(0, std::memory_order_relaxed);
+				_done.store(0, std::memory_order_relaxed);
+				_exception = nullptr;
+				++_generation;
+				lock.unlock();
+				_wake.notify_all();
+
+				in_job() = true;
+				work();
+				in_job() = false;
+
+				lock.lock();
+				_idle.wait(lock, [this] {
+						return _done.load(std::memory_order_acquire) == _count;
+						});
+				if (_exception)
+					std::rethrow_exception(_exception);
+			}
+
+	private:
+		typedef void (*run_t)(void*, size_t);
+
+		std::vector<std::thread> _workers;
+		std::mutex               _submit;
+		std::mutex               _lock;
+		std::condition_variable  _wake;
+		std::condition_variable  _idle;
+		run_t                    _run;
+		void*                    _arg;
+		size_t                   _count;
+		std::atomic<size_t>      _next;
+		std::atomic<size_t>      _done;
+		std::exception_ptr       _exception;
+		size_t                   _generation;
+		size_t                   _active;
+		bool                     _stop;
+
+		template <typename F>
+			static void call(void* f, size_t i) {
+				(*static_cast<F*>(f))(i);
+			}
+
+		static bool& in_job() {
+			static thread_local bool b = false;
+			return b;
+		}
+
+		void work() {
+			for (;;) {
+				const size_t i = _next.fetch_add(1, std::memory_order_relaxed);
+				if (i >= _count)
+					return;
+				try {
+					_run(_arg, i);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(_lock);
+					if (not _exception)
+						_exception = std::current_exception();
+				}
+				if (_done.fetch_add(1, std::memory_order_acq_rel) + 1 == _count) {
+					std::lock_guard<std::mutex> lock(_lock);
+					_idle.notify_all();
+				}
+			}
+		}
+
+		void worker() {
+			in_job() = true;
+			size_t seen = 0;
+			std::unique_lock<std::mutex> lock(_lock);
+			for (;;) {
+				_wake.wait(lock, [&] { return _stop or _generation != seen; });
+				if (_stop)
+					return;
+				seen = _generation;
+				++_active;
+				lock.unlock();
+				work();
+				lock.lock();
+				if (not --_active)
+					_idle.notify_all();
+			}
+		}
+};
+
+// on the default pool.
+template <typename F>
+void parallel_for(size_t n, F f) {
+	thread_pool::instance().parallel_for(n, f);
+}
+
+#endif /* THREAD_POOL_H */
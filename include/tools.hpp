@@ -90,6 +90,25 @@ DEF_IS_EXPR(is_finite_range,
 		size_t((*(U*)0).size()),
 		is_forward_range<T>::value)
 
+// the block protocol: the range is a pipeline (maps, filters) over a
+// contiguous source, see fold_blocks() in algo.hpp.
+template <typename T>
+DEF_IS_EXPR(is_block_range,
+		(*(U*)0).block_source().next_block(),
+		is_forward_range<T>::value)
+
+// random and finite, and drop_front(n) skips n elements at once.
+template <typename T>
+DEF_IS_EXPR(is_droppable_range,
+		(*(U*)0).drop_front(size_t(1)),
+		is_random_range<T>::value and is_finite_range<T>::value)
+
+// the elements are contiguous in memory, next_block() hands them out.
+template <typename T>
+DEF_IS_EXPR(is_contiguous_range,
+		(*(U*)0).next_block(),
+		is_forward_range<T>::value)
+
 template <typename R>
 struct range_info {
 	typedef decltype(((R*)0)->front()) type;
@@ -60,6 +60,29 @@ typename tuple_elem<I, Ts...>::type get(const tuple<Ts...>& t) {
 	return getter<I, Ts...>::get(t);
 }
 
+// the tuple holding the element I as its first, in the inheritance chain.
+template <size_t I, typename T, typename... Ts>
+struct tuple_sub {
+	typedef typename tuple_sub<I-1, Ts...>::type type;
+};
+
+template <typename T, typename... Ts>
+struct tuple_sub<0, T, Ts...> {
+	typedef tuple<T, Ts...> type;
+};
+
+// get() returns the element as declared, a copy for a value. This one is
+// always a reference to the element itself.
+template <size_t I, typename... Ts>
+typename tuple_elem<I, Ts...>::type& get_ref(tuple<Ts...>& t) {
+	return static_cast<typename tuple_sub<I, Ts...>::type&>(t)._p_value;
+}
+
+template <size_t I, typename... Ts>
+const typename tuple_elem<I, Ts...>::type& get_ref(const tuple<Ts...>& t) {
+	return static_cast<const typename tuple_sub<I, Ts...>::type&>(t)._p_value;
+}
+
 template <>
 struct tuple<> {
 	private:
@@ -102,6 +125,8 @@ struct tuple<T, Ts...>: tuple<Ts...> {
 				 // with the second constructor.
 				 typename = typename std::enable_if<
 					 sizeof... (Ts) == sizeof... (Us)
+					 and not std::is_same<typename std::decay<U>::type,
+						 tuple_map_tag_t>::value
 					 >::type>
 			explicit tuple(U&& value, Us&&... values):
 				tuple<Ts...>(std::forward<Us>(values)...),
@@ -117,6 +142,16 @@ struct tuple<T, Ts...>: tuple<Ts...> {
 				_p_value(f(t._p_value)) {
 				}
 
+		// same, but the functor gets non-const references, so it can work
+		// on the elements in place.
+		template <typename F, typename U, typename... Us>
+			explicit tuple(tuple_map_tag_t, F f, tuple<U, Us...>& t):
+				tuple<Ts...>(tuple_map_tag, f,
+						static_cast<tuple<Us...>&>(t)
+						),
+				_p_value(f(t._p_value)) {
+				}
+
 		// a little optimization for an rvalue tuple :)
 		// if the functor support perfect forwarding, you win.
 		template <typename F, typename U, typename... Us>
@@ -0,0 +1,87 @@
+/*
+ * actor.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <coroutine/actor.hpp>
+
+struct msg: coroutine::message {
+	int value; // 0 means stop.
+	msg(int v): value(v) {}
+};
+
+typedef coroutine::actor<msg, coroutine::stack::size_in_kb<64> > actor_t;
+
+int main()
+{
+	std::cout << "ping pong ---" << std::endl;
+	{
+		coroutine::scheduler s;
+		actor_t* pong_ptr = nullptr;
+		int pings = 0;
+		actor_t ping(s, [&](actor_t::yielder_t receive, msg* m) {
+			while (m->value) {
+				++pings;
+				pong_ptr->post(new msg(m->value - 1));
+				delete m;
+				m = receive();
+			}
+			delete m;
+			pong_ptr->post(new msg(0));
+		});
+		actor_t pong(s, [&](actor_t::yielder_t receive, msg* m) {
+			while (m->value) {
+				ping.post(new msg(m->value - 1));
+				delete m;
+				m = receive();
+			}
+			delete m;
+		});
+		pong_ptr = &pong;
+		ping.post(new msg(10));
+		s.run();
+		std::cout << pings << std::endl;
+		if (pings != 5)
+			return 1;
+	}
+
+	std::cout << "many producers ---" << std::endl;
+	{
+		coroutine::scheduler s;
+		const int producers = 4;
+		const int per_producer = 100000;
+		long sum = 0;
+		int stops = 0;
+		actor_t counter(s, [&](actor_t::yielder_t receive, msg* m) {
+			for (;;) {
+				if (not m->value and ++stops == producers) {
+					delete m;
+					return;
+				}
+				sum += m->value;
+				delete m;
+				m = receive();
+			}
+		}, 32);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < producers; ++i) {
+			threads.push_back(std::thread([&] {
+				for (int j = 0; j < per_producer; ++j)
+					counter.post(new msg(1));
+				counter.post(new msg(0));
+			}));
+		}
+		s.run();
+		for (auto& t: threads)
+			t.join();
+		std::cout << sum << std::endl;
+		if (sum != producers * per_producer)
+			return 1;
+	}
+	return 0;
+}
@@ -4,132 +4,24 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <list>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "tools.hpp"
 #include "tuple.hpp"
 #include "range.hpp"
 #include "lambdaexpr.hpp"
+#include "algo.hpp"
 
 #include "cxxabi.cpp"
 #define TN(x) typeName<decltype(x)>()
 
 
-template <typename R>
-bool any(R r) {
-	for (auto x: r) {
-		if (bool(x)) {
-			return true;
-		}
-	}
-	return false;
-}
-
-template <typename R>
-bool all(R r) {
-	for (auto x: r) {
-		if (not bool(x)) {
-			return false;
-		}
-	}
-	return true;
-}
-
-
-// reduce a range though a function
-template <typename F, typename R>
-struct Reducer {
-	typedef decltype( (*(F*)0)( (*(R*)0).front(), (*(R*)0).front()) ) return_t;
-
-	Reducer(F f, R r): _f(f), _r(r) {}
-
-	bool empty() const { return _r.empty(); }
-	void pop_front() { _r.pop_front(); }
-	return_t front() {
-		return _f(_r.front());
-	}
-
-	F _f;
-	R _r;
-};
-
-template <typename F, typename R>
-auto reduce(F f, R r) -> decltype(f(r.front(), r.front())) {
-	if (r.empty()) {
-		throw std::range_error("cannot reduce an empty range!");
-	}
-
-	decltype(f(r.front(), r.front())) sum = r.front();
-	r.pop_front();
-
-	for (auto x: r) {
-		sum = f(sum, x);
-	}
-	return sum;
-}
-
-namespace details {
-
-	struct adder {
-		template <typename A, typename B>
-			auto operator()(const A& a, const B& b) -> decltype(a + b) {
-				return a + b;
-			}
-	};
-
-	struct multiplier {
-		template <typename A, typename B>
-			auto operator()(const A& a, const B& b) -> decltype(a * b) {
-				return a * b;
-			}
-	};
-}
-
-template <typename R>
-auto sum(R r) -> decltype(reduce(details::adder(), r)) {
-	return reduce(details::adder(), r);
-}
-
-template <typename R>
-auto product(R r) -> decltype(reduce(details::multiplier(), r)) {
-	return reduce(details::multiplier(), r);
-}
-
-// filter a range through a function
-template <typename F, typename R>
-struct Filterer {
-	typedef decltype( (*(R*)0).front() ) return_t;
-
-	Filterer(F f, R r): _f(f), _r(r) {
-		_discard();
-	}
-
-	bool empty() const { return _r.empty(); }
-	void pop_front() {
-		_r.pop_front();
-		_discard();
-	}
-	return_t front() {
-		return _r.front();
-	}
-
-	void _discard() {
-		for (auto x: _r) {
-			if (_f(x)) {
-				break;
-			}
-		}
-	}
-
-	F _f;
-	R _r;
-};
-
-template <typename F, typename R>
-Filterer<F, R> filter(F f, R r) { return {f, r}; }
-
 int main()
 {
 	std::cout << std::boolalpha;
@@ -203,4 +95,311 @@ int main()
 		std::cout << x << std::endl;
 	}
 
+	std::cout << "parallel sum ---" << std::endl;
+	const long long n = 1000000;
+	const long long psum = sum(range(1LL, n + 1));
+	std::cout << psum << std::endl;
+	if (psum != n * (n + 1) / 2) {
+		return 1;
+	}
+
+	std::cout << "parallel map/reduce lambda expr ---" << std::endl;
+	static int big[300000];
+	for (int i = 0; i < 300000; ++i) {
+		big[i] = i % 7;
+	}
+	const int pmr = reduce(_1 + _2, map(_1 * 10, arange(big)));
+	std::cout << pmr << std::endl;
+	if (pmr != 10 * sum(arange(big))) {
+		return 1;
+	}
+
+	std::cout << "parallel reduce keeps the order ---" << std::endl;
+	const int last = reduce([](int, int b) { return b; }, range(0, 100000));
+	std::cout << last << std::endl;
+	if (last != 99999) {
+		return 1;
+	}
+
+	std::cout << "blocks ---" << std::endl;
+	static_assert(is_block_range<decltype(
+				filter(_1 > 3, map(_1 * 10, arange(big))))>::value,
+			"is_block_range");
+	static_assert(not is_block_range<decltype(map(_1 * 10, range(3)))>::value,
+			"not is_block_range");
+	long long bs = 0, bms = 0, bfs = 0, bfms = 0;
+	for (int i = 0; i < 300000; ++i) {
+		bs += big[i];
+		bms += big[i] * 10;
+		bfs += big[i] > 3 ? big[i] : 0;
+		bfms += big[i] * 3 > 10 ? big[i] * 3 : 0;
+	}
+	const int s1 = sum(arange(big));
+	const int s2 = sum(map(_1 * 10, arange(big)));
+	const int s3 = sum(filter(_1 > 3, arange(big)));
+	const int s4 = sum(filter(_1 > 10, map(_1 * 3, arange(big))));
+	std::cout << s1 << " " << s2 << " " << s3 << " " << s4 << std::endl;
+	if (s1 != bs or s2 != bms or s3 != bfs or s4 != bfms) {
+		return 1;
+	}
+	int small[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+	const int p1 = product(arange(small));
+	const int p2 = product(filter(_1 % 2, arange(small)));
+	std::cout << p1 << " " << p2 << std::endl;
+	if (p1 != 39916800 or p2 != 10395) {
+		return 1;
+	}
+	// the mapped element is computed once per element of the block, kept
+	// or not (the filter already skipped 1 to 5 when constructed).
+	int nm = 0;
+	auto fm = filter([](int v) { return v > 5; },
+			map([&nm](int v) { ++nm; return v; }, arange(small)));
+	nm = 0;
+	const int s5 = sum(fm);
+	std::cout << s5 << " " << nm << std::endl;
+	if (s5 != 6 + 7 + 8 + 9 + 10 + 11 or nm != 6) {
+		return 1;
+	}
+	// adapters over the array are not block ranges: they are walked in
+	// their own order, with their own elements.
+	static_assert(not is_block_range<decltype(reverse(arange(big)))>::value,
+			"not is_block_range");
+	typedef tuple<size_t, int&> indexed_t;
+	const size_t s6 = sum(map([](indexed_t e) { return get<0>(e); },
+				enumerate(arange(small))));
+	int last_kept = 0;
+	for (int x: filter([](int v) { return v % 2 == 0; },
+				reverse(arange(small)))) {
+		last_kept = x;
+	}
+	std::cout << s6 << " " << last_kept << std::endl;
+	if (s6 != 55 or last_kept != 2) {
+		return 1;
+	}
+
+	std::cout << "fused pipeline ---" << std::endl;
+	int nf = 0, ng = 0, np = 0;
+	auto f = [&nf](int v) { ++nf; return v + 1; };
+	auto g = [&ng](int v) { ++ng; return v * 3; };
+	auto pr = [&np](int v) { ++np; return v % 2 == 0; };
+	int fsum = 0, outs = 0;
+	for (auto fp = pipe(range(10)).filter(pr).map(g).map(f);
+			not fp.empty(); fp.pop_front()) {
+		// front() twice: computed once.
+		fsum += fp.front() + fp.front();
+		++outs;
+	}
+	std::cout << fsum << " " << outs << " " << np << " " << ng << " " << nf
+		<< std::endl;
+	if (fsum != 2 * (0 + 6 + 12 + 18 + 24 + 5) or outs != 5
+			or np != 10 or ng != 5 or nf != 5) {
+		return 1;
+	}
+	nf = ng = np = 0;
+	int fused = 0;
+	for (auto x: fuse(map(f, map(g, filter(pr, range(10)))))) {
+		fused += x;
+	}
+	std::cout << fused << " " << np << " " << ng << " " << nf << std::endl;
+	if (fused != fsum / 2 or ng != 5 or nf != 5) {
+		return 1;
+	}
+
+	std::cout << "thread pool ---" << std::endl;
+	thread_pool pool(4);
+	std::atomic<long long> acc(0);
+	for (int round = 0; round < 100; ++round) {
+		pool.parallel_for(1000, [&](size_t i) {
+				acc += i;
+				// nested: runs inline.
+				pool.parallel_for(2, [&](size_t j) { acc += j; });
+			});
+	}
+	std::cout << acc << std::endl;
+	if (acc != 100 * (999 * 1000 / 2 + 1000)) {
+		return 1;
+	}
+	try {
+		pool.parallel_for(100, [](size_t i) {
+				if (i == 42) {
+					throw std::runtime_error("42");
+				}
+			});
+		return 1;
+	} catch (const std::runtime_error& e) {
+		std::cout << e.what() << std::endl;
+	}
+
+	std::cout << "par pipeline ---" << std::endl;
+	std::vector<int> src(100000);
+	for (size_t i = 0; i < src.size(); ++i) {
+		src[i] = i;
+	}
+	ArrayRange<int> asrc(src.data(), src.size());
+	std::atomic<int> calls(0);
+	auto seq = pipe(asrc).filter([](int v) { return v % 3; })
+		.map([&calls](int v) {
+			++calls;
+			return v * 2;
+		});
+	std::vector<int> expect;
+	for (auto x: fuse(seq)) {
+		expect.push_back(x);
+	}
+	calls = 0;
+	std::vector<int> ordered;
+	for (auto x: par(seq).on(pool).morsel(1000)) {
+		ordered.push_back(x);
+	}
+	std::cout << ordered.size() << " " << calls << std::endl;
+	if (ordered != expect or calls != int(expect.size())) {
+		return 1;
+	}
+	// Mappers and Filterers are fused first.
+	const long long parsum = sum(par(map(_1 + 1LL,
+					filter(_1 % 3, asrc))));
+	long long esum = 0;
+	for (int x: expect) {
+		esum += x / 2 + 1;
+	}
+	// with the index, and a last morsel left empty by the filter.
+	size_t pos = 0;
+	for (auto x: par(pipe(enumerate(asrc)).filter(
+				[](tuple<size_t, int&> t) { return get<1>(t) < 99999; }))
+			.on(pool).morsel(7)) {
+		if (get<0>(x) != pos or get<1>(x) != int(pos)) {
+			return 1;
+		}
+		++pos;
+	}
+	std::cout << parsum << " " << pos << std::endl;
+	if (parsum != esum or pos != 99999 or not par(range(0)).empty()) {
+		return 1;
+	}
+
+	std::cout << "top_k ---" << std::endl;
+	std::vector<int> scores(100000);
+	unsigned seed = 42;
+	for (int& x: scores) {
+		seed = seed * 1103515245 + 12345;
+		x = seed >> 16;
+	}
+	std::vector<int> best(scores);
+	std::sort(best.begin(), best.end(), [](int a, int b) { return a > b; });
+	best.resize(100);
+	// random and finite: by chunks. Then one by one, and with a key.
+	ArrayRange<int> ascores(scores.data(), scores.size());
+	auto t1 = top_k(100, _1 * 10, ascores);
+	auto t2 = top_k(100, _1 + 0, filter(_1 >= 0, ascores));
+	auto t3 = top_k(3, -_1, range(10));
+	std::cout << t1.front() << " " << t1.back() << " " << t3[0] << t3[1]
+		<< t3[2] << std::endl;
+	if (t1 != best or t2 != best or t3 != std::vector<int>{0, 1, 2}
+			or not top_k(0, _1, ascores).empty()
+			or top_k(5, _1, range(2)).size() != 2) {
+		return 1;
+	}
+
+	std::cout << "group_by ---" << std::endl;
+	// random and finite: by chunks. Then one by one.
+	auto g1 = group_by(_1 % 1000, _1 + _2, range(100000));
+	auto g2 = group_by(_1 % 1000, _1 + _2, filter(_1 >= 0, asrc));
+	size_t groups = 0;
+	for (auto e: g1.items()) {
+		const int k = get<0>(e);
+		// k + (k + 1000) + ... + (k + 99000)
+		if (get<1>(e) != 100 * k + 1000 * 99 * 100 / 2
+				or not g2.find(k) or *g2.find(k) != get<1>(e)) {
+			return 1;
+		}
+		++groups;
+	}
+	std::cout << g1.size() << " " << groups << " " << *g1.find(7) << std::endl;
+	if (groups != 1000 or g1.find(1000) or g2.size() != 1000) {
+		return 1;
+	}
+	typedef std::pair<std::string, int> count_t;
+	std::string words[] = { "a", "b", "a", "c", "b", "a" };
+	auto counts = group_by([](const count_t& c) { return c.first; },
+			[](count_t a, const count_t& b) { a.second += b.second; return a; },
+			map([](const std::string& w) { return count_t(w, 1); },
+				arange(words)));
+	std::cout << counts.find("a")->second << counts.find("b")->second
+		<< counts.find("c")->second << std::endl;
+	if (counts.size() != 3 or counts.find("a")->second != 3) {
+		return 1;
+	}
+
+	std::cout << "hash_join ---" << std::endl;
+	typedef std::pair<int, std::string> user_t;
+	user_t users[] = { {1, "ann"}, {2, "bob"}, {3, "cid"}, {2, "bea"} };
+	int orders[] = { 2, 5, 1, 2, 3 };
+	std::string joined;
+	for (auto e: hash_join(arange(users), arange(orders),
+				[](const user_t& u) { return u.first; }, _1)) {
+		joined += get<0>(e).second + std::to_string(get<1>(e)) + " ";
+	}
+	std::cout << joined << std::endl;
+	if (joined != "bob2 bea2 ann1 bob2 bea2 cid3 ") {
+		return 1;
+	}
+	// partitioned first: 1M entries of 16 bytes.
+	std::vector<int> keys(1 << 20);
+	for (size_t i = 0; i < keys.size(); ++i) {
+		keys[i] = i * 7;
+	}
+	size_t matches = 0;
+	long long msum = 0;
+	for (auto e: hash_join(ArrayRange<int>(keys.data(), keys.size()),
+				range(0, 1 << 20), _1 + 0, [](int x) { return x * 3; })) {
+		if (get<0>(e) != get<1>(e) * 3) {
+			return 1;
+		}
+		++matches;
+		msum += get<1>(e);
+	}
+	std::cout << matches << " " << msum << std::endl;
+	// x * 3 a multiple of 7: x a multiple of 7.
+	const long long mcount = ((1 << 20) - 1) / 7 + 1;
+	if (matches != size_t(mcount) or msum != 7 * mcount * (mcount - 1) / 2
+			or not hash_join(range(0), range(5), _1, _1).empty()) {
+		return 1;
+	}
+
+	std::cout << "scan ---" << std::endl;
+	for (auto x: inclusive_scan(_1 + _2, range(1, 6))) {
+		std::cout << x << " ";
+	}
+	std::cout << "| ";
+	for (auto x: exclusive_scan(_1 * _2, 1, range(1, 6))) {
+		std::cout << x << " ";
+	}
+	std::cout << std::endl;
+	// compaction: where every kept element goes.
+	auto keep = map([](int x) { return x % 3 == 0 ? 1 : 0; }, range(100000));
+	auto offsets = par_exclusive_scan(_1 + _2, 0, keep);
+	auto kept = par_inclusive_scan(_1 + _2, keep);
+	auto seq_offsets = exclusive_scan(_1 + _2, 0, keep);
+	for (size_t i = 0; i < offsets.size(); ++i, seq_offsets.pop_front()) {
+		if (offsets[i] != seq_offsets.front()
+				or kept[i] != offsets[i] + keep[i]
+				or (i % 3 == 0 and offsets[i] != int(i / 3))) {
+			return 1;
+		}
+	}
+	std::cout << offsets.size() << " " << kept.back() << std::endl;
+	if (offsets.size() != 100000 or kept.back() != 33334
+			or not par_inclusive_scan(_1 + _2, range(0)).empty()
+			or par_exclusive_scan(_1 + _2, 7, range(1)) != std::vector<int>{7}) {
+		return 1;
+	}
+
+	std::cout << "empty ---" << std::endl;
+	try {
+		sum(range(0));
+		return 1;
+	} catch (const std::range_error& e) {
+		std::cout << e.what() << std::endl;
+	}
+	return 0;
 }
@@ -0,0 +1,129 @@
+/*
+ * any_coroutine.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <coroutine/any_coroutine.hpp>
+
+typedef coroutine::any_coroutine<int (),
+		coroutine::stack::size_in_kb<64> > gen_t;
+
+int count(coroutine::yielder<int ()> yield, int n) {
+	for (int i = 0; i < n; ++i)
+		yield(i);
+	return n;
+}
+
+int main()
+{
+	std::cout << "shared type ---" << std::endl;
+	auto l1 = [](coroutine::yielder<int ()>) { return 1; };
+	auto l2 = [](coroutine::yielder<int ()>) { return 2; };
+	gen_t a(l1);
+	gen_t b(l2);
+	static_assert(std::is_same<decltype(a.get()), decltype(b.get())>::value,
+			"one coroutine type per signature");
+	std::cout << a() << " " << b() << " " << bool(a) << std::endl;
+	if (a or b)
+		return 1;
+
+	std::cout << "heterogeneous container ---" << std::endl;
+	std::vector<gen_t> gens;
+	gens.emplace_back([](coroutine::yielder<int ()> yield) {
+			yield(100);
+			return 200;
+		});
+	gens.emplace_back(std::bind(&count, std::placeholders::_1, 3));
+	int base = 1000;
+	gens.emplace_back([base](coroutine::yielder<int ()> yield) mutable {
+			yield(base++);
+			return base;
+		});
+	// moved around while suspended.
+	int sum = gens[0]();
+	gens.reserve(64);
+	for (gen_t& g: gens)
+		while (g)
+			sum += g();
+	std::cout << sum << std::endl;
+	if (sum != 100 + 200 + 0 + 1 + 2 + 3 + 1000 + 1001)
+		return 2;
+
+	std::cout << "feed value ---" << std::endl;
+	coroutine::any_coroutine<int (int)> acc(
+			[](coroutine::yielder<int (int)> yield, int v) {
+				int total = 0;
+				while (v) {
+					total += v;
+					v = yield(total);
+				}
+				return total;
+			});
+	acc(1); acc(2);
+	const int total = acc(3);
+	std::cout << total << " " << acc(0) << std::endl;
+	if (total != 6)
+		return 3;
+
+	std::cout << "void ---" << std::endl;
+	int steps = 0;
+	coroutine::any_coroutine<void ()> v(
+			[&steps](coroutine::yielder<void ()> yield) {
+				++steps;
+				yield();
+				++steps;
+			});
+	while (v)
+		v();
+	std::cout << steps << std::endl;
+	if (steps != 2)
+		return 4;
+
+	std::cout << "yield from ---" << std::endl;
+	gen_t inner(std::bind(&count, std::placeholders::_1, 2));
+	gen_t outer([&inner](coroutine::yielder<int ()> yield) {
+			yield.from(inner.get());
+			return 10;
+		});
+	sum = 0;
+	while (outer)
+		sum += outer();
+	std::cout << sum << std::endl;
+	if (sum != 0 + 1 + 2 + 10)
+		return 5;
+
+	std::cout << "stackless ---" << std::endl;
+	int i = 0;
+	coroutine::any_coroutine<int (), coroutine::kind::stackless> s(
+			[i](coroutine::stackless_yielder<int ()> yield) mutable -> int {
+				CORO_REENTER(yield) {
+					for (i = 0; i < 3; ++i)
+						CORO_YIELD(yield, i);
+				}
+				return 3;
+			});
+	sum = 0;
+	while (s)
+		sum += s();
+	std::cout << sum << std::endl;
+	if (sum != 6)
+		return 6;
+
+	std::cout << "exception ---" << std::endl;
+	gen_t t([](coroutine::yielder<int ()>) -> int {
+			throw std::runtime_error("boom");
+		});
+	try {
+		t();
+		return 7;
+	} catch (const std::runtime_error& e) {
+		std::cout << e.what() << " " << bool(t) << std::endl;
+	}
+	return 0;
+}
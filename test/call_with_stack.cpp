@@ -0,0 +1,50 @@
+/*
+ * call_with_stack.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <string>
+
+#include <coroutine/call_with_stack.hpp>
+
+// about 1KB of stack per level.
+int deep(int n) {
+	volatile char buf[1024];
+	buf[0] = n;
+	return n == 0 ? buf[0] : deep(n - 1) + 1;
+}
+
+int main()
+{
+	std::cout << "deep recursion ---" << std::endl;
+	// ~30MB, way more than the default 8MB of the main thread.
+	const int d = coroutine::call_with_stack(64 << 20, deep, 30000);
+	std::cout << d << std::endl;
+	if (d != 30000)
+		return 1;
+
+	std::cout << "reference ---" << std::endl;
+	int v = 42;
+	int& r = coroutine::call_with_stack(1 << 20,
+			[](int& v) -> int& { return v; }, v);
+	std::cout << (&r == &v) << std::endl;
+
+	std::cout << "by value ---" << std::endl;
+	std::string s = coroutine::call_with_stack(1 << 20,
+			[](const std::string& a) { return a + " world"; },
+			std::string("hello"));
+	std::cout << s << std::endl;
+
+	std::cout << "exception ---" << std::endl;
+	try {
+		coroutine::call_with_stack(1 << 20, [] {
+				throw std::runtime_error("thrown on the big stack");
+			});
+		return 1;
+	} catch(const std::exception& e) {
+		std::cout << "caught! -> " << e.what() << std::endl;
+	}
+	return 0;
+}
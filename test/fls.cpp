@@ -0,0 +1,79 @@
+/*
+ * fls.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <string>
+
+#include <coroutine/builder.hpp>
+#include <coroutine/scheduler.hpp>
+
+coroutine::fiber_local<int>         trace_id;
+coroutine::fiber_local<std::string> user;
+
+int main()
+{
+	std::cout << "thread ---" << std::endl;
+	trace_id = 1;
+	std::cout << *trace_id << " " << (user.get() == nullptr) << std::endl;
+
+	std::cout << "interleaved coroutines ---" << std::endl;
+	auto make = [](int id, const char* name) {
+		return [=](coroutine::yielder<int ()> yield) {
+			trace_id = id;
+			user = name;
+			for (int i = 0; i < 3; ++i) {
+				std::cout << *user << " " << *trace_id << std::endl;
+				yield(*trace_id);
+			}
+			return *trace_id;
+		};
+	};
+	auto a = coroutine::coro<int (), coroutine::stack::size_in_kb<64> >(
+			make(10, "alice"));
+	auto b = coroutine::coro<int (), coroutine::stack::size_in_kb<64> >(
+			make(20, "bob"));
+	int sum = 0;
+	while (a or b) {
+		if (a) sum += a();
+		if (b) sum += b();
+	}
+	std::cout << sum << " " << *trace_id << std::endl;
+	if (sum != 120 or *trace_id != 1 or user.get())
+		return 1;
+
+	std::cout << "stackless ---" << std::endl;
+	auto c = coroutine::coro<int (), coroutine::kind::stackless>(
+			[](coroutine::stackless_yielder<int ()> yield) -> int {
+				CORO_REENTER(yield) {
+					trace_id = 30;
+					CORO_YIELD(yield, *trace_id);
+				}
+				return *trace_id + 1;
+			});
+	const int c1 = c();
+	const int c2 = c();
+	std::cout << c1 << " " << c2 << " " << *trace_id << std::endl;
+	if (c1 != 30 or c2 != 31 or *trace_id != 1 or c)
+		return 1;
+
+	std::cout << "scheduler ---" << std::endl;
+	coroutine::scheduler s;
+	int seen[3] = {};
+	for (int i = 0; i < 3; ++i) {
+		s.spawn([i, &seen] {
+			trace_id = 100 + i;
+			coroutine::scheduler::yield();
+			seen[i] = *trace_id;
+			std::cout << "task " << i << ": " << seen[i] << std::endl;
+		});
+	}
+	s.run();
+	for (int i = 0; i < 3; ++i) {
+		if (seen[i] != 100 + i)
+			return 1;
+	}
+	return *trace_id == 1 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/*
+ * generator.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <range.hpp>
+#include <coroutine/builder.hpp>
+#include <coroutine/generator.hpp>
+
+// the state of a stackless coroutine lives in the functor.
+struct counter {
+	int i, n;
+
+	int operator()(coroutine::stackless_yielder<int ()> yield) {
+		CORO_REENTER(yield) {
+			for (i = 0; i < n; ++i)
+				CORO_YIELD(yield, i);
+		}
+		return n;
+	}
+};
+
+// start, start + step ... m values, counting its resumes.
+struct strided {
+	int i, start, step, m;
+	int* resumes;
+
+	int operator()(coroutine::stackless_yielder<int ()> yield) {
+		++*resumes;
+		CORO_REENTER(yield) {
+			for (i = 0; i < m - 1; ++i)
+				CORO_YIELD(yield, start + i * step);
+		}
+		return start + i * step;
+	}
+};
+
+typedef coroutine::stack::size_in_kb<64> small_stack;
+
+// n, n-1 ... 0 ... -(n-1), -n, every level delegating to the next one.
+struct chain {
+	int n;
+
+	int operator()(coroutine::yielder<int ()> yield) {
+		if (n == 0)
+			return 0;
+		yield(n);
+		auto sub = coroutine::coro<int (), small_stack>(chain{n - 1});
+		yield.from(sub);
+		return -n;
+	}
+};
+
+// yields 1, then throws.
+struct failing {
+	int operator()(coroutine::yielder<int ()> yield) {
+		yield(1);
+		throw std::runtime_error("boom");
+	}
+};
+
+// never gets past its from(): the exception goes through it.
+struct passing {
+	int operator()(coroutine::yielder<int ()> yield) {
+		auto sub = coroutine::coro<int (), small_stack>(failing());
+		yield.from(sub);
+		yield(42);
+		return 43;
+	}
+};
+
+// catches it out of its own from().
+struct catching {
+	int operator()(coroutine::yielder<int ()> yield) {
+		auto sub = coroutine::coro<int (), small_stack>(passing());
+		try {
+			yield.from(sub);
+		} catch (const std::runtime_error&) {
+			yield(-1);
+		}
+		return 100;
+	}
+};
+
+template <typename G>
+int sum(G& g) {
+	int r = 0;
+	for (auto x: coroutine::as_range(g)) {
+		std::cout << x << " | ";
+		r += x;
+	}
+	std::cout << std::endl;
+	return r;
+}
+
+int main()
+{
+	std::cout << "stackful ---" << std::endl;
+	auto a = coroutine::coro<int (), small_stack>(
+			[](coroutine::yielder<int ()> yield) {
+				for (int i = 0; i < 5; ++i)
+					yield(i);
+				return 5;
+			});
+	const int sa = sum(a);
+
+	std::cout << "stackless ---" << std::endl;
+	auto b = coroutine::coro<int (), coroutine::kind::stackless>(
+			counter{0, 5});
+	const int sb = sum(b);
+
+	std::cout << "stackless lambda ---" << std::endl;
+	int i = 0;
+	auto c = coroutine::coro<int (), coroutine::kind::stackless>(
+			[=](coroutine::stackless_yielder<int ()> yield) mutable -> int {
+				CORO_REENTER(yield) {
+					for (; i < 5; ++i)
+						CORO_YIELD(yield, i);
+				}
+				return 5;
+			});
+	const int sc = sum(c);
+
+	std::cout << sa << " " << sb << " " << sc << std::endl;
+	if (sa != 15 or sb != 15 or sc != 15)
+		return 1;
+
+	std::cout << "yield from ---" << std::endl;
+	auto d = coroutine::coro<int (), small_stack>(chain{5});
+	const int sd = sum(d);
+
+	auto e = coroutine::coro<int (), small_stack>(chain{200});
+	int cnt = 0;
+	for (auto x: coroutine::as_range(e)) {
+		(void)x;
+		++cnt;
+	}
+	std::cout << sd << " " << cnt << std::endl;
+	if (sd != 0 or cnt != 401)
+		return 1;
+
+	std::cout << "yield from a throwing delegate ---" << std::endl;
+	auto f = coroutine::coro<int (), small_stack>(catching());
+	std::vector<int> fv;
+	while (f)
+		fv.push_back(f());
+	auto g = coroutine::coro<int (), small_stack>(passing());
+	const int g1 = g();
+	bool thrown = false;
+	try {
+		g();
+	} catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	std::cout << fv.size() << " " << g1 << " " << thrown << " " << bool(g)
+		<< std::endl;
+	if (fv != std::vector<int>{ 1, -1, 100 } or g1 != 1 or not thrown or g)
+		return 1;
+
+	std::cout << "merge ---" << std::endl;
+	const int k = 64, m = 100;
+	int resumes = 0;
+	typedef decltype(coroutine::coro<int (), coroutine::kind::stackless>(
+				strided())) strided_t;
+	std::vector<strided_t> gens;
+	gens.reserve(k);
+	std::vector<coroutine::generator_range<strided_t> > heads;
+	for (int j = 0; j < k; ++j) {
+		gens.push_back(coroutine::coro<int (), coroutine::kind::stackless>(
+					strided{0, j, k, m, &resumes}));
+		heads.push_back(coroutine::as_range(gens.back()));
+	}
+	int expected = 0;
+	for (int x: merge(heads)) {
+		if (x != expected)
+			return 1;
+		++expected;
+	}
+	std::cout << expected << " " << resumes << std::endl;
+	if (expected != k * m or resumes != k * m)
+		return 1;
+
+	try {
+		b();
+	} catch(const std::exception& e) {
+		std::cout << "terminated! -> " << e.what() << std::endl;
+	}
+	return 0;
+}
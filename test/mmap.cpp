@@ -0,0 +1,84 @@
+/*
+ * mmap.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "range.hpp"
+#include "algo.hpp"
+#include "mmap.hpp"
+
+static std::string temp_file(const void* data, size_t size) {
+	char path[] = "/tmp/mmap_test_XXXXXX";
+	const int fd = ::mkstemp(path);
+	if (fd < 0 or ::write(fd, data, size) != ssize_t(size)) {
+		throw std::runtime_error("cannot write a temporary file");
+	}
+	::close(fd);
+	return path;
+}
+
+int main()
+{
+	std::cout << "records ---" << std::endl;
+	int ints[1000];
+	for (int i = 0; i < 1000; ++i) {
+		ints[i] = i;
+	}
+	// and a trailing incomplete record.
+	const std::string ipath = temp_file(ints, sizeof ints - 1);
+	auto r = mmap_range<int>(ipath);
+	const long long total = sum(map([](int x) { return x + 0LL; }, r));
+	int zipped = 0;
+	for (auto e: zip(r, range(1000))) {
+		zipped += get<0>(e) == get<1>(e);
+	}
+	std::cout << r.size() << " " << r[998] << " " << total << " " << zipped
+		<< std::endl;
+	if (r.size() != 999 or r[998] != 998 or total != 998 * 999 / 2
+			or zipped != 999) {
+		return 1;
+	}
+	// the mapping outlives the file name, and goes with the last copy.
+	::unlink(ipath.c_str());
+	auto copy = r;
+	r = mmap_range<int>("/dev/null");
+	std::cout << copy.front() << " " << r.empty() << std::endl;
+	if (copy.front() != 0 or not r.empty()) {
+		return 1;
+	}
+
+	std::cout << "lines ---" << std::endl;
+	const char text[] = "one\ntwo\r\n\nthree, not terminated";
+	const std::string lpath = temp_file(text, sizeof text - 1);
+	size_t n = 0, bytes = 0;
+	for (auto line: lines(lpath)) {
+		std::cout << "[" << std::string(line.begin(), line.end()) << "]"
+			<< std::endl;
+		bytes += line.size;
+		++n;
+	}
+	auto longer = filter([](Span<const char> l) { return l.size > 3; },
+			lines(lpath, MADV_RANDOM));
+	const std::string three(longer.front().begin(), longer.front().end());
+	::unlink(lpath.c_str());
+	if (n != 4 or bytes != 3 + 3 + 0 + 21
+			or three != "three, not terminated") {
+		return 1;
+	}
+
+	std::cout << "missing ---" << std::endl;
+	try {
+		lines("/nonexistent/file");
+		return 1;
+	} catch (const std::runtime_error& e) {
+		std::cout << e.what() << std::endl;
+	}
+	return 0;
+}
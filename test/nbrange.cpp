@@ -84,4 +84,43 @@ int main()
 
 	test(1, 4, 1);
 	test(1.0, 2.0, 0.3);
+
+	std::cout << "constexpr ---" << std::endl;
+	static_assert(range(0, 10, 3).size() == 4, "size");
+	static_assert(range(0, 10, 3)[3] == 9, "operator[]");
+	static_assert(range(10, 0, 3).back() == 1, "back");
+	static_assert(range(1, 101).sum() == 5050, "sum");
+	static_assert(range(0).empty(), "empty");
+
+	std::cout << "no accumulated error ---" << std::endl;
+	auto f = range(1.0, 2.0, 0.3);
+	std::cout << f.size() << " " << f.back() << std::endl;
+	if (f.size() != 4 or f.back() != 1.0 + 3 * 0.3) {
+		return 1;
+	}
+	for (size_t i = 0; not f.empty(); f.pop_front(), ++i) {
+		if (f.front() != 1.0 + i * 0.3) {
+			return 1;
+		}
+	}
+
+	std::cout << "closed form sum ---" << std::endl;
+	for (auto r: { range(3, 1000, 7), range(-5, -1000, 3), range(0, 1) }) {
+		long long loop = 0;
+		for (size_t i = 0; i < r.size(); ++i) {
+			loop += r[i];
+		}
+		std::cout << r.sum() << " " << loop << std::endl;
+		if (r.sum() != loop) {
+			return 1;
+		}
+	}
+	// n(n - 1) would not fit in a size_t, the sum does.
+	const unsigned long long big = 5000000000ULL;
+	std::cout << range(0ULL, big).sum() << std::endl;
+	if (range(0ULL, big).sum() != 12499999997500000000ULL
+			or range(0ULL, big + 1).sum() != 12500000002500000000ULL) {
+		return 1;
+	}
+	return 0;
 }
@@ -0,0 +1,112 @@
+/*
+ * parser.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <coroutine/parser.hpp>
+
+typedef coroutine::stack::size_in_kb<64> small_stack;
+
+std::string frame(const std::string& msg) {
+	std::string r;
+	const size_t n = msg.size();
+	r += char(n >> 24); r += char(n >> 16); r += char(n >> 8); r += char(n);
+	return r + msg;
+}
+
+// feed the stream by chunks of n bytes.
+template <typename P>
+	void feed(P& p, const std::string& stream, size_t n) {
+		for (size_t i = 0; i < stream.size(); i += n)
+			p(coroutine::slice(stream.data() + i,
+						std::min(n, stream.size() - i)));
+		p(coroutine::slice());
+	}
+
+int main()
+{
+	std::cout << "length prefixed ---" << std::endl;
+	const std::vector<std::string> msgs = {
+		"hello", "", "a longer message, straddling chunks", "x" };
+	std::string stream;
+	for (const std::string& m: msgs)
+		stream += frame(m);
+	for (size_t n = 1; n <= stream.size(); ++n) {
+		std::vector<std::string> got;
+		auto p = coroutine::make_parser<small_stack>(
+				coroutine::decoder::length_prefixed(
+					[&got](coroutine::slice m) { got.push_back(m.str()); }));
+		feed(p, stream, n);
+		if (got != msgs or p) {
+			std::cout << "chunk size " << n << " failed" << std::endl;
+			return 1;
+		}
+	}
+	std::cout << msgs.size() << " messages, every chunk size" << std::endl;
+
+	std::cout << "zero copy ---" << std::endl;
+	{
+		const char* first = nullptr;
+		auto p = coroutine::make_parser<small_stack>(
+				coroutine::decoder::length_prefixed(
+					[&first](coroutine::slice m) {
+						if (not first) first = m.data;
+					}));
+		p(coroutine::slice(stream));
+		const bool in_place = first == stream.data() + 4;
+		std::cout << in_place << std::endl;
+		if (not in_place)
+			return 2;
+	}
+
+	std::cout << "lines ---" << std::endl;
+	const std::string text = "first\r\nsecond\n\nlast without newline";
+	for (size_t n = 1; n <= text.size(); ++n) {
+		std::vector<std::string> got;
+		auto p = coroutine::make_parser<small_stack>(
+				coroutine::decoder::lines(
+					[&got](coroutine::slice l) { got.push_back(l.str()); }));
+		feed(p, text, n);
+		const std::vector<std::string> expected = {
+			"first", "second", "", "last without newline" };
+		if (got != expected) {
+			std::cout << "chunk size " << n << " failed" << std::endl;
+			return 3;
+		}
+	}
+	std::cout << "4 lines, every chunk size" << std::endl;
+
+	std::cout << "custom parser ---" << std::endl;
+	int sum = 0;
+	auto p = coroutine::make_parser<small_stack>(
+			[&sum](coroutine::reader& in) {
+				while (in.more()) {
+					const coroutine::slice tag = in.take(1);
+					if (tag[0] == '+')
+						sum += std::stoi(in.take_until(';').str());
+					else
+						in.skip(2);
+				}
+			});
+	feed(p, "+12;?ab+30;+100;", 4);
+	std::cout << sum << std::endl;
+	if (sum != 142)
+		return 4;
+
+	std::cout << "truncated ---" << std::endl;
+	auto t = coroutine::make_parser<small_stack>(
+			coroutine::decoder::length_prefixed([](coroutine::slice) {}));
+	try {
+		feed(t, frame("truncated").substr(0, 8), 3);
+		return 5;
+	} catch (const std::runtime_error& e) {
+		std::cout << e.what() << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * preempt.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+#include <coroutine/scheduler.hpp>
+
+typedef coroutine::stack::size_in_kb<64> small_stack;
+typedef std::chrono::steady_clock clock_type;
+
+int main()
+{
+	std::cout << "preempted hog ---" << std::endl;
+	coroutine::scheduler s;
+	s.time_slice(std::chrono::milliseconds(1));
+
+	bool stop = false;
+	bool gave_up = false;
+	int polite_runs = 0;
+	// never yields by itself, only reaches safe points.
+	coroutine::task& hog = s.spawn<small_stack>([&] {
+			const clock_type::time_point deadline =
+				clock_type::now() + std::chrono::seconds(5);
+			volatile unsigned long spin = 0;
+			while (not stop) {
+				++spin;
+				coroutine::scheduler::preemption_point();
+				if (clock_type::now() > deadline) {
+					gave_up = true;
+					return;
+				}
+			}
+		});
+	s.spawn<small_stack>([&] {
+			for (int i = 0; i < 3; ++i) {
+				++polite_runs;
+				coroutine::scheduler::yield();
+			}
+			stop = true;
+		});
+	const size_t slice_us = hog.time_slice().count();
+	s.run();
+	std::cout << slice_us << " " << polite_runs << " " << gave_up << std::endl;
+	if (gave_up or polite_runs != 3 or slice_us != 1000)
+		return 1;
+
+	std::cout << "per task slice ---" << std::endl;
+	coroutine::scheduler s2;
+	size_t preemptions = 0;
+	coroutine::task& t = s2.spawn<small_stack>([&] {
+			coroutine::task& self = coroutine::scheduler::running();
+			const clock_type::time_point end =
+				clock_type::now() + std::chrono::milliseconds(50);
+			while (clock_type::now() < end)
+				coroutine::scheduler::preemption_point();
+			preemptions = self.preemptions();
+		});
+	t.time_slice(std::chrono::milliseconds(2));
+	s2.run();
+	std::cout << (preemptions >= 5) << std::endl;
+	if (preemptions < 5)
+		return 2;
+
+	std::cout << "not timed ---" << std::endl;
+	coroutine::scheduler s3;
+	s3.spawn<small_stack>([&] {
+			const clock_type::time_point end =
+				clock_type::now() + std::chrono::milliseconds(10);
+			while (clock_type::now() < end)
+				coroutine::scheduler::preemption_point();
+			preemptions = coroutine::scheduler::running().preemptions();
+		});
+	s3.run();
+	std::cout << preemptions << std::endl;
+	return preemptions != 0;
+}
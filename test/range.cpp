@@ -4,8 +4,11 @@
  *
 */
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <list>
+#include <vector>
 
 #include "cxxabi.cpp"
 #define TN(x) typeName<decltype(x)>()
@@ -60,6 +63,21 @@ struct {
 		T operator()(T v) { return v * 2; }
 } op;
 
+// counts how many times it is copied.
+struct CountedRange {
+	static int copies;
+	int i, n;
+
+	CountedRange(int n): i(0), n(n) {}
+	CountedRange(const CountedRange& from): i(from.i), n(from.n) { ++copies; }
+
+	bool empty() const { return i >= n; }
+	void pop_front() { ++i; }
+	int front() const { return i; }
+	size_t size() const { return n - i; }
+};
+int CountedRange::copies = 0;
+
 
 int main()
 {
@@ -193,5 +211,180 @@ int main()
 	for (auto e: longzip(-1, range(5), range(3), range(7), range(1))) {
 		std::cout << e << std::endl;
 	}
+
+	std::cout << "zip by reference ---" << std::endl;
+	auto zc = zip(arange(a), CountedRange(5), CountedRange(7));
+	auto lzc = longzip(-1, arange(a), CountedRange(3), CountedRange(7));
+	CountedRange::copies = 0;
+	int zsum = 0;
+	for (auto e: zc) {
+		zsum += get<0>(e) + get<1>(e) + get<2>(e);
+	}
+	int lzsum = 0, lzcnt = 0;
+	for (auto e: lzc) {
+		lzsum += get<0>(e) + get<1>(e) + get<2>(e);
+		++lzcnt;
+	}
+	std::cout << zsum << " " << lzsum << " " << lzcnt << " "
+		<< CountedRange::copies << std::endl;
+	// a is { 2, 3, 4, 5, 6 } since longzip3, the fill value counts as -1.
+	if (CountedRange::copies != 0 or lzcnt != 7 or zsum != 40
+			or lzsum != 38) {
+		return 1;
+	}
+
+	std::cout << "chunk ---" << std::endl;
+	int ca[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	int csum = 0, cnt = 0;
+	for (auto s: chunk(4, arange(ca))) {
+		// straight into the array.
+		if (s.data != ca + 4 * cnt++) {
+			return 1;
+		}
+		for (int& x: s) {
+			std::cout << x << " ";
+			csum += x;
+		}
+		std::cout << "| ";
+	}
+	std::cout << std::endl;
+	const int* buf = nullptr;
+	for (auto s: chunk(3, map([](int x) { return x * 10; }, range(8)))) {
+		// the same buffer, refilled.
+		if (buf and s.data != buf) {
+			return 1;
+		}
+		buf = s.data;
+		for (int x: s) {
+			std::cout << x << " ";
+			csum += x;
+		}
+		std::cout << "| ";
+	}
+	std::cout << std::endl;
+	if (csum != 55 + 280 or cnt != 3 or not chunk(2, range(0)).empty()) {
+		return 1;
+	}
+	// no std::vector<bool> in the way.
+	int odd = 0, bcnt = 0;
+	for (auto s: chunk(4, map([](int x) { return x % 2 == 1; }, range(10)))) {
+		for (bool b: s) {
+			std::cout << b;
+			odd += b;
+		}
+		std::cout << "| ";
+		++bcnt;
+	}
+	std::cout << std::endl;
+	if (odd != 5 or bcnt != 3) {
+		return 1;
+	}
+	// adapters over an array are not contiguous, they are copied.
+	static_assert(not is_contiguous_range<decltype(reverse(arange(ca)))>::value,
+			"not is_contiguous_range");
+	std::vector<int> rev, idx;
+	for (auto s: chunk(4, reverse(arange(ca)))) {
+		for (int x: s) {
+			std::cout << x << " ";
+			rev.push_back(x);
+		}
+		std::cout << "| ";
+	}
+	for (auto s: chunk(4, enumerate(arange(ca), 100))) {
+		for (auto e: s) {
+			std::cout << get<0>(e) << ":" << get<1>(e) << " ";
+			idx.push_back(int(get<0>(e)) * get<1>(e));
+		}
+		std::cout << "| ";
+	}
+	std::cout << std::endl;
+	if (rev != std::vector<int>{ 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 }
+			or idx.size() != 10 or idx[0] != 100 or idx[9] != 109 * 10) {
+		return 1;
+	}
+
+	std::cout << "set operations ---" << std::endl;
+	int s1[] = { 1, 2, 2, 2, 4, 7, 9 };
+	int s2[] = { 2, 2, 3, 7, 10 };
+	for (auto x: set_intersection(arange(s1), arange(s2))) {
+		std::cout << x << " ";
+	}
+	std::cout << "| ";
+	for (auto x: set_union(arange(s1), arange(s2))) {
+		std::cout << x << " ";
+	}
+	std::cout << "| ";
+	for (auto x: set_difference(arange(s1), arange(s2))) {
+		std::cout << x << " ";
+	}
+	std::cout << "| ";
+	for (auto x: set_difference(range(12), arange(s1))) {
+		std::cout << x << " ";
+	}
+	std::cout << std::endl;
+	// big against small, and both big: against the std:: algorithms.
+	std::vector<int> m3, m5, few = { -4, 15, 90000, 90001, 299985, 400000 };
+	for (int i = 0; i < 300000; i += 3) {
+		m3.push_back(i);
+	}
+	for (int i = 0; i < 300000; i += 5) {
+		m5.push_back(i);
+	}
+	typedef std::vector<int> ints_t;
+	auto check = [](const ints_t& a, const ints_t& b) {
+		ArrayRange<int> ra(const_cast<int*>(a.data()), a.size());
+		ArrayRange<int> rb(const_cast<int*>(b.data()), b.size());
+		ints_t ei, eu, ed, gi, gu, gd;
+		std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+				std::back_inserter(ei));
+		std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+				std::back_inserter(eu));
+		std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+				std::back_inserter(ed));
+		for (int x: set_intersection(ra, rb)) { gi.push_back(x); }
+		for (int x: set_union(ra, rb)) { gu.push_back(x); }
+		for (int x: set_difference(ra, rb)) { gd.push_back(x); }
+		std::cout << gi.size() << " " << gu.size() << " " << gd.size() << " ";
+		return gi == ei and gu == eu and gd == ed;
+	};
+	const bool sets_ok = check(m3, m5) and check(m5, m3) and check(few, m3)
+		and check(m5, few);
+	std::cout << std::endl;
+	// maps of droppable ranges gallop too.
+	int mapped = 0;
+	for (int x: set_intersection(
+				map([](int x) { return x * 3; }, range(100000)), arange(s1))) {
+		mapped += x;
+	}
+	// a reversed source, sorted by greater: it drops from its back.
+	int up[20], hi[] = { 3, 1 };
+	for (int i = 0; i < 20; ++i) {
+		up[i] = i;
+	}
+	std::vector<int> ri, rd;
+	for (int x: set_intersection(reverse(arange(up)), arange(hi),
+				std::greater<int>())) {
+		ri.push_back(x);
+	}
+	for (int x: set_difference(arange(hi), reverse(arange(up)),
+				std::greater<int>())) {
+		rd.push_back(x);
+	}
+	// and an enumerated one keeps counting.
+	auto en = enumerate(arange(up));
+	en.drop_front(5);
+	auto ef = en.front();
+	std::cout << ri.size() << " " << rd.size() << " " << get<0>(ef)
+		<< std::endl;
+	if (not sets_ok or mapped != 9 or ri != std::vector<int>{ 3, 1 }
+			or not rd.empty() or get<0>(ef) != 5 or get<1>(ef) != 5) {
+		return 1;
+	}
+
+	std::cout << "merge ---" << std::endl;
+	for (auto e: merge(range(0, 10, 3), range(1, 10, 4), range(5, 6))) {
+		std::cout << e << " ";
+	}
+	std::cout << std::endl;
 	return 0;
 }
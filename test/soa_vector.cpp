@@ -0,0 +1,95 @@
+/*
+ * soa_vector.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "range.hpp"
+#include "algo.hpp"
+#include "soa_vector.hpp"
+
+// its copy throws when asked to.
+struct Thrower {
+	bool fail;
+	Thrower(bool f): fail(f) {}
+	Thrower(const Thrower& from): fail(from.fail) {
+		if (fail) {
+			throw std::runtime_error("copy");
+		}
+	}
+};
+
+int main()
+{
+	std::cout << "push & rows ---" << std::endl;
+	soa_vector<int, double, std::string> v;
+	if (not v.empty() or not v.rows().empty() or not v.column<2>().empty()) {
+		return 1;
+	}
+	v.reserve(100);
+	for (int i = 0; i < 100; ++i) {
+		v.push_back(i, i * 0.5, std::to_string(i));
+	}
+	for (auto row: v.rows()) {
+		get<1>(row) *= 2;
+	}
+	get<2>(v[42]) += "!";
+	std::cout << v.size() << " " << get<1>(v[10]) << " " << get<2>(v[42])
+		<< std::endl;
+	if (v.size() != 100 or get<1>(v[10]) != 10.0 or get<2>(v[42]) != "42!") {
+		return 1;
+	}
+
+	std::cout << "columns ---" << std::endl;
+	// contiguous, and alone.
+	auto ints = v.column<0>();
+	if (&ints[1] - &ints[0] != 1 or &ints[99] - &ints[0] != 99) {
+		return 1;
+	}
+	const soa_vector<int, double, std::string>& cv = v;
+	const int isum = sum(cv.column<0>());
+	const double dsum = sum(v.column<1>());
+	int zipped = 0;
+	for (auto e: zip(cv.column<0>(), range(100), cv.column<2>())) {
+		zipped += get<0>(e) == get<1>(e)
+			and std::to_string(get<1>(e)) == get<2>(e);
+	}
+	std::cout << isum << " " << dsum << " " << zipped << std::endl;
+	if (isum != 4950 or dsum != 4950.0 or zipped != 99) {
+		return 1;
+	}
+
+	std::cout << "resize ---" << std::endl;
+	v.pop_back();
+	v.resize(120);
+	size_t rows = 0;
+	for (auto row: cv.rows()) {
+		rows += get<2>(row).empty();
+	}
+	std::cout << v.size() << " " << rows << std::endl;
+	v.clear();
+	if (rows != 21 or not v.empty() or not v.column<1>().empty()) {
+		return 1;
+	}
+
+	std::cout << "throwing push ---" << std::endl;
+	soa_vector<int, std::string, Thrower> t;
+	t.push_back(1, "one", Thrower{false});
+	try {
+		t.push_back(2, "two", Thrower{true});
+		return 1;
+	} catch (const std::runtime_error& e) {
+		std::cout << e.what() << std::endl;
+	}
+	std::cout << t.size() << " " << t.column<0>().size() << " "
+		<< t.column<1>().size() << std::endl;
+	if (t.size() != 1 or t.column<1>().size() != 1
+			or t.column<2>().size() != 1) {
+		return 1;
+	}
+	return 0;
+}
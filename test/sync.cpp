@@ -0,0 +1,117 @@
+/*
+ * sync.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <thread>
+
+#include <coroutine/sync.hpp>
+
+int main()
+{
+	std::cout << "mutex ---" << std::endl;
+	{
+		coroutine::scheduler s;
+		coroutine::mutex m;
+		int counter = 0;
+		for (int i = 0; i < 4; ++i) {
+			s.spawn([&, i] {
+				for (int j = 0; j < 3; ++j) {
+					std::lock_guard<coroutine::mutex> lock(m);
+					const int v = counter;
+					// everybody else get a chance to run while we hold it.
+					coroutine::scheduler::yield();
+					counter = v + 1;
+					std::cout << "task " << i << ": " << counter << std::endl;
+				}
+			});
+		}
+		s.run();
+		std::cout << counter << std::endl;
+		if (counter != 12)
+			return 1;
+	}
+
+	std::cout << "condition_variable ---" << std::endl;
+	{
+		coroutine::scheduler s;
+		coroutine::mutex m;
+		coroutine::condition_variable cond;
+		std::deque<int> queue;
+		bool done = false;
+		s.spawn([&] {
+			for (;;) {
+				std::unique_lock<coroutine::mutex> lock(m);
+				cond.wait(lock, [&] { return done or not queue.empty(); });
+				if (queue.empty())
+					break;
+				std::cout << "consume " << queue.front() << std::endl;
+				queue.pop_front();
+			}
+		});
+		s.spawn([&] {
+			for (int i = 0; i < 5; ++i) {
+				{
+					std::lock_guard<coroutine::mutex> lock(m);
+					queue.push_back(i);
+					std::cout << "produce " << i << std::endl;
+				}
+				cond.notify_one();
+				coroutine::scheduler::yield();
+			}
+			std::lock_guard<coroutine::mutex> lock(m);
+			done = true;
+			cond.notify_all();
+		});
+		s.run();
+	}
+
+	std::cout << "semaphore ---" << std::endl;
+	{
+		coroutine::scheduler s;
+		coroutine::semaphore sem(2);
+		int inside = 0;
+		int max_inside = 0;
+		for (int i = 0; i < 5; ++i) {
+			s.spawn([&] {
+				sem.acquire();
+				max_inside = std::max(max_inside, ++inside);
+				coroutine::scheduler::yield();
+				--inside;
+				sem.release();
+			});
+		}
+		s.run();
+		std::cout << max_inside << std::endl;
+		if (max_inside != 2)
+			return 1;
+	}
+
+	std::cout << "cross-thread ---" << std::endl;
+	{
+		coroutine::scheduler s1, s2;
+		coroutine::mutex m;
+		long counter = 0;
+		for (int i = 0; i < 8; ++i) {
+			auto work = [&] {
+				for (int j = 0; j < 1000; ++j) {
+					std::lock_guard<coroutine::mutex> lock(m);
+					const long v = counter;
+					coroutine::scheduler::yield();
+					counter = v + 1;
+				}
+			};
+			s1.spawn(work);
+			s2.spawn(work);
+		}
+		std::thread t([&] { s2.run(); });
+		s1.run();
+		t.join();
+		std::cout << counter << std::endl;
+		if (counter != 16000)
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * trim.cpp
+ * Copyright © 2012 François-Xavier 'Bombela' Bourlet <bombela@gmail.com>
+ *
+*/
+
+#include <iostream>
+#include <fstream>
+
+#include <coroutine/builder.hpp>
+#include <coroutine/scheduler.hpp>
+
+// resident memory, in pages.
+static size_t resident() {
+	size_t size, rss;
+	std::ifstream("/proc/self/statm") >> size >> rss;
+	return rss;
+}
+
+// touch about 1KB of stack per level.
+__attribute__((noinline))
+static int deep(int n) {
+	volatile char buf[1024];
+	for (size_t i = 0; i < sizeof buf; i += 256)
+		buf[i] = n;
+	return n == 0 ? 0 : deep(n - 1) + buf[0];
+}
+
+int main()
+{
+	std::cout << "trim_stack ---" << std::endl;
+	auto c = coroutine::coro<void ()>([](coroutine::yielder<void ()> yield) {
+			deep(8 * 1024);
+			yield();
+		});
+	const size_t before = resident();
+	c();
+	const size_t peak = resident();
+	const size_t released = c.trim_stack();
+	const size_t after = resident();
+	std::cout << "released " << released / 1024 << "KB" << std::endl;
+	std::cout << "rss grown " << (peak > before + 1024) << std::endl;
+	std::cout << "rss shrank " << (after + 1024 < peak) << std::endl;
+	if (released < 8 * 1024 * 1024 or after + 1024 >= peak)
+		return 1;
+
+	std::cout << "scheduler sweep ---" << std::endl;
+	coroutine::scheduler s;
+	s.trim_stacks_every(1);
+	s.spawn([] {
+		deep(8 * 1024);
+		coroutine::scheduler::yield();
+		deep(8 * 1024);
+	});
+	size_t swept = 0;
+	s.spawn([&] {
+		// the first task is suspended at a shallow yield.
+		swept = coroutine::scheduler::current()->trim_stacks();
+	});
+	s.run();
+	std::cout << "swept " << (swept >= 8 * 1024 * 1024) << std::endl;
+	return swept >= 8 * 1024 * 1024 ? 0 : 1;
+}